@@ -0,0 +1,95 @@
+/*
+ * os_fiber_t costs: one yield (fiber -> scheduler -> next fiber), and creating,
+ * running and destroying many fibers with small stacks.
+ *
+ * Build with 'make bench'.
+*/
+#include "../inc/fiber.h"
+#include "../inc/time.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_YIELDS	1000000U
+#define BENCH_FIBERS	10000U
+#define BENCH_STACK		(16U * 1024U)
+
+static uint64_t g_count;
+
+/* ------------------------------------------------------------ */
+
+static void
+bench_yielder(void *arg)
+{
+	(void) arg;
+
+	for (uint32_t i = 0U; i < BENCH_YIELDS; i++)
+	{
+		g_count++;
+
+		os_fiber_yield();
+	}
+}
+
+static void
+bench_short(void *arg)
+{
+	(void) arg;
+
+	g_count++;
+
+	/* Touch the stack once more after a switch, like a flow waiting for I/O */
+	os_fiber_yield();
+}
+
+int
+main()
+{
+	os_fiber_sched_t sched;
+	os_fiber_t pair[2];
+	os_fiber_t *many;
+	os_time_t start;
+	long ns;
+
+	/* Two fibers ping-ponging through the scheduler */
+	os_fiber_sched_init(&sched);
+	os_fiber_init(&pair[0], &sched, bench_yielder, NULL, BENCH_STACK);
+	os_fiber_init(&pair[1], &sched, bench_yielder, NULL, BENCH_STACK);
+
+	start = os_time_monotonic();
+	os_fiber_sched_run(&sched, NULL);
+	ns = os_time_diff_ns(start, os_time_monotonic());
+
+	printf("yield:                %5.1f ns\n", (double) ns / (2.0 * BENCH_YIELDS));
+
+	os_fiber_destroy(&pair[0]);
+	os_fiber_destroy(&pair[1]);
+
+	/* Many short-lived fibers */
+	many = calloc(BENCH_FIBERS, sizeof(*many));
+	if (NULL == many)
+		return 1;
+
+	start = os_time_monotonic();
+
+	for (uint32_t i = 0U; i < BENCH_FIBERS; i++)
+	{
+		if (-1 == os_fiber_init(&many[i], &sched, bench_short, NULL, BENCH_STACK))
+			return 1;
+	}
+
+	os_fiber_sched_run(&sched, NULL);
+
+	for (uint32_t i = 0U; i < BENCH_FIBERS; i++)
+		os_fiber_destroy(&many[i]);
+
+	ns = os_time_diff_ns(start, os_time_monotonic());
+
+	printf("init + run + destroy: %5.1f us per fiber (%u fibers, %u KB stacks)\n",
+		   (double) ns / BENCH_FIBERS / 1e3, BENCH_FIBERS, BENCH_STACK / 1024U);
+
+	free(many);
+
+	return (0U == g_count) ? 1 : 0;
+}
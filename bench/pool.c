@@ -0,0 +1,114 @@
+/*
+ * os_pool_parallel_for() scaling benchmark on a compute-only kernel (no shared writes
+ * except one atomic add per chunk). Runs the same range with 1, 2, 4, ... workers up to
+ * the number of online CPUs and reports the speedup over one worker.
+ *
+ * Build with 'make bench'; scaling needs a host with more than one CPU.
+*/
+#include "../inc/pool.h"
+#include "../inc/time.h"
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define BENCH_RANGE		(1U << 22)
+#define BENCH_ROUNDS	64U
+#define BENCH_REPEAT	5U
+
+static uint64_t g_sum;
+
+/* ------------------------------------------------------------ */
+
+static void
+bench_kernel(void *ctx, size_t begin, size_t end)
+{
+	uint64_t sum = 0U;
+
+	(void) ctx;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		uint64_t x = (uint64_t) i + 1U;
+
+		/* xorshift rounds keep the kernel in registers */
+		for (uint32_t r = 0U; r < BENCH_ROUNDS; r++)
+		{
+			x ^= x << 13;
+			x ^= x >> 7;
+			x ^= x << 17;
+		}
+
+		sum += x;
+	}
+
+	__atomic_fetch_add(&g_sum, sum, __ATOMIC_RELAXED);
+}
+
+static long
+bench_run(uint32_t workers)
+{
+	os_pool_t pool;
+	os_time_t start;
+	long best = 0;
+
+	if (-1 == os_pool_init(&pool, workers, 0U))
+		return -1;
+
+	/* Best of a few runs; the first one also warms up the workers */
+	for (uint32_t i = 0U; i < BENCH_REPEAT; i++)
+	{
+		long ns;
+
+		start = os_time_monotonic();
+
+		os_pool_parallel_for(&pool, 0U, BENCH_RANGE, 0U, bench_kernel, NULL);
+
+		ns = os_time_diff_ns(start, os_time_monotonic());
+
+		if (0 == best || ns < best)
+			best = ns;
+	}
+
+	os_pool_destroy(&pool);
+
+	return best;
+}
+
+int
+os_runtime_enter()
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	long base = 0;
+
+	printf("parallel_for over %u indexes, %u xorshift rounds each\n", BENCH_RANGE, BENCH_ROUNDS);
+
+	for (uint32_t workers = 1U; workers <= (uint32_t)((ncpu > 0) ? ncpu : 1); workers *= 2U)
+	{
+		long ns = bench_run(workers);
+
+		if (ns <= 0)
+			break;
+
+		if (0 == base)
+			base = ns;
+
+		printf("workers %3u: %8.2f ms  speedup %5.2fx\n", workers, (double) ns / 1e6, (double) base / (double) ns);
+	}
+
+	/* Keep the kernel from being optimized out */
+	printf("checksum %llx\n", (unsigned long long) g_sum);
+
+	/* Leave the runtime loop */
+	kill(getpid(), SIGTERM);
+
+	return 0;
+}
+
+int
+os_runtime_exit()
+{
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+ * os_queue_t benchmark: round trips between two tasks (head/tail traffic between cores)
+ * and posts with many queues in the list (subscription lookups).
+ *
+ * Build with 'make bench' and pin to two cores, e.g. 'taskset -c 0,2 bench_queue'.
+*/
+#include "../inc/errno.h"
+#include "../inc/queue.h"
+#include "../inc/task.h"
+#include "../inc/time.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define BENCH_ROUNDS	200000U
+#define BENCH_POSTS		1000000U
+#define BENCH_QUEUES	64U
+#define BENCH_POOL		16U
+
+#define BENCH_MSG_PING	1U
+
+static os_msg_t g_pool_main[BENCH_POOL];
+static os_msg_t g_pool_echo[BENCH_POOL];
+static os_msg_t g_pool_subs[BENCH_QUEUES][BENCH_POOL];
+
+static os_queue_t g_queue_main;
+static os_queue_t g_queue_echo;
+static os_queue_t g_queue_subs[BENCH_QUEUES];
+
+static os_task_t g_task_echo;
+
+/* ------------------------------------------------------------ */
+
+static void
+bench_recv(os_queue_t *q, os_msg_t *msg, os_task_t *task)
+{
+	uint32_t spins = 0U;
+
+	/* Spin briefly, then let the other side run (single CPU hosts) */
+	while (-1 == os_queue_recv(q, msg) && (NULL == task || !os_task_check_stop(task)))
+	{
+		if (++spins > 1000U)
+			sched_yield();
+	}
+}
+
+static void *
+bench_echo(void *param)
+{
+	os_task_t *task = param;
+	os_msg_t msg;
+
+	while (!os_task_check_stop(task))
+	{
+		bench_recv(&g_queue_echo, &msg, task);
+
+		if (!os_task_check_stop(task))
+			os_queue_send1(&g_queue_echo, &g_queue_main, 0U, BENCH_MSG_PING, msg.params[0U]);
+	}
+
+	return NULL;
+}
+
+static void
+bench_round_trips()
+{
+	os_time_t start;
+	os_msg_t msg;
+	long ns;
+
+	os_queue_init(&g_queue_main, g_pool_main, BENCH_POOL);
+	os_queue_init(&g_queue_echo, g_pool_echo, BENCH_POOL);
+
+	os_task_init(&g_task_echo, "bench_echo", bench_echo, &g_task_echo);
+
+	start = os_time_monotonic();
+
+	for (uint32_t i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		os_queue_send1(&g_queue_main, &g_queue_echo, 0U, BENCH_MSG_PING, i);
+
+		bench_recv(&g_queue_main, &msg, NULL);
+	}
+
+	ns = os_time_diff_ns(start, os_time_monotonic());
+
+	printf("round trip:  %8.1f ns (%u rounds)\n", (double) ns / BENCH_ROUNDS, BENCH_ROUNDS);
+
+	/* Unblock the echo task's receive loop */
+	os_task_stop(&g_task_echo);
+	os_task_destroy(&g_task_echo);
+
+	os_queue_destroy(&g_queue_echo);
+	os_queue_destroy(&g_queue_main);
+}
+
+static void
+bench_posts()
+{
+	os_time_t start;
+	os_msg_t msg;
+	long ns;
+
+	/* Each queue subscribes to its own message ID; only the first one receives the posts */
+	for (uint32_t i = 0U; i < BENCH_QUEUES; i++)
+	{
+		os_queue_init(&g_queue_subs[i], g_pool_subs[i], BENCH_POOL);
+		os_queue_sub(&g_queue_subs[i], BENCH_MSG_PING + i);
+	}
+
+	start = os_time_monotonic();
+
+	for (uint32_t i = 0U; i < BENCH_POSTS; i++)
+	{
+		os_queue_post1(&g_queue_subs[0U], BENCH_MSG_PING, i);
+		os_queue_recv(&g_queue_subs[0U], &msg);
+	}
+
+	ns = os_time_diff_ns(start, os_time_monotonic());
+
+	printf("post + recv: %8.1f ns (%u queues)\n", (double) ns / BENCH_POSTS, BENCH_QUEUES);
+
+	for (uint32_t i = 0U; i < BENCH_QUEUES; i++)
+		os_queue_destroy(&g_queue_subs[i]);
+}
+
+int
+os_runtime_enter()
+{
+	printf("os_queue_t: %zu bytes\n", sizeof(os_queue_t));
+
+	bench_round_trips();
+	bench_posts();
+
+	/* Leave the runtime loop */
+	kill(getpid(), SIGTERM);
+
+	return 0;
+}
+
+int
+os_runtime_exit()
+{
+	return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * os_rbuf_find() against the byte-by-byte os_rbuf_peek_u8() scan it replaces: find a
+ * delimiter at the end of 64 KB of data that wraps around the pool boundary.
+ *
+ * Build with 'make bench'.
+*/
+#include "../inc/rbuf.h"
+#include "../inc/time.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_POOL		(1U << 17)
+#define BENCH_USED		(1U << 16)
+#define BENCH_ROUNDS	2000U
+
+static uint8_t g_pool[BENCH_POOL];
+static uint8_t g_data[BENCH_USED];
+
+/* ------------------------------------------------------------ */
+
+static int
+bench_find_peek(os_rbuf_t *p, uint8_t value, uint32_t *p_pos)
+{
+	uint32_t used = os_rbuf_used(p);
+	uint8_t c;
+
+	for (uint32_t i = 0U; i < used; i++)
+	{
+		if (0 == os_rbuf_peek_u8(p, i, &c) && value == c)
+		{
+			*p_pos = i;
+
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+int
+main()
+{
+	const uint8_t crlf[2] = { '\r', '\n' };
+	os_rbuf_t rb;
+	os_time_t start;
+	uint32_t pos = 0U;
+	uint32_t sum = 0U;
+	long ns;
+
+	/* Printable data with the only delimiter at the very end */
+	memset(g_data, 'x', sizeof(g_data));
+	g_data[BENCH_USED - 2U] = '\r';
+	g_data[BENCH_USED - 1U] = '\n';
+
+	os_rbuf_init(&rb, g_pool, BENCH_POOL);
+
+	/* Used region straddles the wrap point */
+	rb.head = rb.tail = BENCH_POOL - (BENCH_USED / 2U);
+	os_rbuf_push(&rb, g_data, BENCH_USED);
+
+	start = os_time_monotonic();
+	for (uint32_t i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		os_rbuf_find_u8(&rb, 0U, '\n', &pos);
+		sum += pos;
+	}
+	ns = os_time_diff_ns(start, os_time_monotonic());
+	printf("os_rbuf_find_u8:  %10.2f us per 64 KB scan\n", (double) ns / BENCH_ROUNDS / 1e3);
+
+	start = os_time_monotonic();
+	for (uint32_t i = 0U; i < BENCH_ROUNDS; i++)
+	{
+		os_rbuf_find(&rb, 0U, crlf, sizeof(crlf), &pos);
+		sum += pos;
+	}
+	ns = os_time_diff_ns(start, os_time_monotonic());
+	printf("os_rbuf_find \\r\\n: %10.2f us per 64 KB scan\n", (double) ns / BENCH_ROUNDS / 1e3);
+
+	start = os_time_monotonic();
+	for (uint32_t i = 0U; i < BENCH_ROUNDS / 10U; i++)
+	{
+		bench_find_peek(&rb, '\n', &pos);
+		sum += pos;
+	}
+	ns = os_time_diff_ns(start, os_time_monotonic());
+	printf("peek_u8 loop:     %10.2f us per 64 KB scan\n", (double) ns / (BENCH_ROUNDS / 10U) / 1e3);
+
+	printf("delimiter at offset %u\n", pos);
+
+	/* Keep the scans from being optimized out */
+	return (0U == sum) ? 1 : 0;
+}
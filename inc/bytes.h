@@ -7,6 +7,12 @@
 #error "Compiler macro __BYTE_ORDER__ is not defined!"
 #endif
 
+/**
+ * CPU cache line size in bytes. Fields written by different threads are placed this
+ * far apart so the threads don't keep taking the same line from each other.
+*/
+#define CACHE_LINE_SIZE (64U)
+
 /**
  * Create bitfield variable. To access individual bits, simply
  * access the desired bit variable (f_example_flag). To read/write
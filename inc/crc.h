@@ -0,0 +1,62 @@
+#ifndef OS_CRC_H
+#define OS_CRC_H
+#include "rbuf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Compute (or continue) a CRC32C (Castagnoli) checksum. Uses the SSE4.2 / ARMv8 CRC32
+ * instructions when available, slice-by-8 tables otherwise.
+ *
+ * @param crc		Previous checksum (0 to start a new checksum)
+ * @param data		Bytes to checksum
+ * @param len		Number of bytes
+ *
+ * @return The updated checksum
+*/
+uint32_t os_crc32c(uint32_t crc, const uint8_t *data, size_t len);
+
+/**
+ * Compute (or continue) a CRC16-CCITT checksum (polynomial 0x1021, not reflected).
+ *
+ * @param crc		Initial value or previous checksum (0xFFFF = CCITT-FALSE, 0x0000 = XMODEM)
+ * @param data		Bytes to checksum
+ * @param len		Number of bytes
+ *
+ * @return The updated checksum
+*/
+uint16_t os_crc16_ccitt(uint16_t crc, const uint8_t *data, size_t len);
+
+/**
+ * Compute a CRC32C checksum directly over used ring buffer data (across the wrap
+ * boundary of the pool) without removing it.
+ *
+ * @param[in] offset
+ * 		Offset (from the head of the used data) of the first byte.
+ *
+ * @param[in] len
+ * 		Number of bytes to checksum.
+ *
+ * @param[in] seed
+ * 		Previous checksum (0 to start a new checksum).
+ *
+ * @param[out] p_crc
+ * 		The updated checksum.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf_crc32c(os_rbuf_t *p, uint32_t offset, uint32_t len, uint32_t seed, uint32_t *p_crc);
+
+/**
+ * Compute a CRC16-CCITT checksum directly over used ring buffer data. Same as
+ * os_rbuf_crc32c() using os_crc16_ccitt().
+*/
+int os_rbuf_crc16(os_rbuf_t *p, uint32_t offset, uint32_t len, uint16_t seed, uint16_t *p_crc);
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef OS_FIBER_H
+#define OS_FIBER_H
+#include "task.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Architectures without a hand-written context switch use ucontext */
+#if !defined(__x86_64__) && !defined(__aarch64__)
+#define OS_FIBER_UCONTEXT 1
+#include <ucontext.h>
+#endif
+
+/* Default fiber stack size (os_fiber_init() with stack_size = 0) */
+#define OS_FIBER_STACK_SIZE (64U * 1024U)
+
+typedef void (*os_fiber_func_f)(void *arg);
+
+/* Fiber states */
+typedef enum
+{
+	OS_FIBER_READY = 0,
+	OS_FIBER_RUNNING = 1,
+	OS_FIBER_SUSPENDED = 2,
+	OS_FIBER_DONE = 3
+} OS_FIBER_STATE;
+
+struct os_fiber_sched_s;
+
+/* Fiber control block */
+typedef struct os_fiber_s
+{
+	/* Saved stack pointer while not running */
+	void *sp;
+
+#ifdef OS_FIBER_UCONTEXT
+	ucontext_t ctx;
+#endif
+
+	/* Stack mapping (lowest page is a guard page) */
+	uint8_t *stack;
+	size_t stack_size;
+
+	os_fiber_func_f p_func;
+	void *p_func_arg;
+
+	struct os_fiber_sched_s *sched;
+
+	/* Run queue link */
+	struct os_fiber_s *next;
+
+	OS_FIBER_STATE state;
+} os_fiber_t;
+
+/**
+ * Cooperative fiber scheduler. Fibers run one at a time on the thread calling
+ * os_fiber_sched_run() (typically an os_task_t) and switch only when they yield,
+ * suspend or return.
+*/
+typedef struct os_fiber_sched_s
+{
+	/* Scheduler context saved while a fiber runs */
+	void *sp;
+
+#ifdef OS_FIBER_UCONTEXT
+	ucontext_t ctx;
+#endif
+
+	/* Ready queue (FIFO) */
+	os_fiber_t *head;
+	os_fiber_t *tail;
+
+	os_fiber_t *current;
+
+	/* Number of fibers that have not finished */
+	uint32_t count;
+} os_fiber_sched_t;
+
+/**
+ * Initialize a fiber scheduler.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_fiber_sched_init(os_fiber_sched_t *s);
+
+/**
+ * Run fibers on the calling thread until all of them have finished (or are suspended
+ * with nothing left to run), or the host task is asked to stop.
+ *
+ * @param[in] s
+ * 		Pointer to os_fiber_sched_t object.
+ *
+ * @param[in] host
+ * 		Task running the scheduler, checked with os_task_check_stop() between fiber
+ * 		switches. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_fiber_sched_run(os_fiber_sched_t *s, os_task_t *host);
+
+/**
+ * Create a fiber with a guard-page protected stack and make it ready to run on the
+ * scheduler. Must be called from the scheduler's thread (or before it runs).
+ *
+ * @param[in] f
+ * 		Pointer to os_fiber_t object.
+ *
+ * @param[in] s
+ * 		Scheduler to run the fiber on.
+ *
+ * @param[in] p_func
+ * 		Fiber function; the fiber finishes when it returns.
+ *
+ * @param[in] p_func_arg
+ * 		Argument passed to the fiber function. This value can be left NULL.
+ *
+ * @param[in] stack_size
+ * 		Usable stack size in bytes, rounded up to pages (0 = OS_FIBER_STACK_SIZE).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOMEM
+*/
+int os_fiber_init(os_fiber_t *f, os_fiber_sched_t *s, os_fiber_func_f p_func, void *p_func_arg, size_t stack_size);
+
+/**
+ * Release the stack of a fiber that is not running. A ready fiber is removed from the
+ * scheduler's run queue and a suspended one is dropped; neither is resumed again.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN	-	Fiber is running
+*/
+int os_fiber_destroy(os_fiber_t *f);
+
+/**
+ * Let the other ready fibers run; the calling fiber is queued again at the end.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL	-	Not called from a fiber
+*/
+int os_fiber_yield();
+
+/**
+ * Stop running the calling fiber until os_fiber_resume() is called for it.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL	-	Not called from a fiber
+*/
+int os_fiber_suspend();
+
+/**
+ * Make a suspended fiber ready again. Must be called from the scheduler's thread.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_fiber_resume(os_fiber_t *f);
+
+/**
+ * Get the fiber running on the calling thread (NULL if not called from a fiber).
+*/
+os_fiber_t *os_fiber_current();
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef OS_FRAME_H
+#define OS_FRAME_H
+#include "rbuf.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum length of a frame delimiter (OS_FRAME_DELIM) */
+#define OS_FRAME_DELIM_MAX 8U
+
+/* Framing types */
+typedef enum
+{
+	/* Length-prefixed frames */
+	OS_FRAME_LEN = 0,
+
+	/* Frames terminated by a delimiter byte sequence */
+	OS_FRAME_DELIM = 1,
+
+	/* RFC 1055 SLIP frames (terminated by 0xC0) */
+	OS_FRAME_SLIP = 2,
+
+	/* COBS encoded frames (terminated by 0x00) */
+	OS_FRAME_COBS = 3
+} OS_FRAME_TYPE;
+
+/**
+ * Frame decoder state. Extracts complete frames from an os_rbuf_t incrementally; bytes
+ * already inspected while waiting for the end of a frame are not scanned again. While a
+ * decoder is in use, data must only be removed from the ring buffer by os_frame_consume()
+ * or os_frame_decode().
+*/
+typedef struct
+{
+	OS_FRAME_TYPE type;
+
+	/* Length prefix width in bytes (1, 2 or 4) */
+	uint8_t len_width;
+
+	/* Length prefix byte order */
+	bool len_big_endian;
+
+	/* Length prefix value includes the prefix itself */
+	bool len_inclusive;
+
+	/* Largest accepted payload (0 = as much as fits in the ring buffer) */
+	uint32_t max_len;
+
+	uint8_t  delim[OS_FRAME_DELIM_MAX];
+	uint32_t delim_len;
+
+	/* Number of bytes already scanned for the end of the current frame */
+	uint32_t scanned;
+
+	/* Raw length (including framing) of the frame returned by os_frame_peek() */
+	uint32_t frame_len;
+
+	/* Rest of a rejected frame, dropped once its located part is consumed */
+	uint32_t frame_skip;
+	bool frame_skip_delim;
+
+	/* Payload bytes of a rejected frame still to be dropped as they arrive */
+	uint32_t skip;
+
+	/* Drop data up to and including the next delimiter (tail of a rejected frame) */
+	bool skip_delim;
+} os_frame_t;
+
+/**
+ * Initialize a length-prefixed frame decoder.
+ *
+ * @param[in] f
+ * 		Pointer to os_frame_t object.
+ *
+ * @param[in] width
+ * 		Length prefix width in bytes (1, 2 or 4).
+ *
+ * @param[in] big_endian
+ * 		True = big endian length prefix, False = little endian.
+ *
+ * @param[in] inclusive
+ * 		True if the length prefix counts its own bytes.
+ *
+ * @param[in] max_len
+ * 		Largest accepted payload in bytes (0 = as much as fits in the ring buffer). Larger
+ * 		frames, including ones that could never fit in the ring buffer, are rejected with
+ * 		OS_EOVERFLOW.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_frame_init_len(os_frame_t *f, uint8_t width, bool big_endian, bool inclusive, uint32_t max_len);
+
+/**
+ * Initialize a delimiter-terminated frame decoder (e.g. "\r\n" for lines).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_frame_init_delim(os_frame_t *f, const uint8_t *delim, uint32_t delim_len, uint32_t max_len);
+
+/**
+ * Initialize a SLIP (RFC 1055) frame decoder.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_frame_init_slip(os_frame_t *f, uint32_t max_len);
+
+/**
+ * Initialize a COBS frame decoder (0x00 frame delimiter).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_frame_init_cobs(os_frame_t *f, uint32_t max_len);
+
+/**
+ * Forget scan progress (e.g. after the ring buffer was flushed).
+*/
+void os_frame_reset(os_frame_t *f);
+
+/**
+ * Locate the next complete frame without copying. For OS_FRAME_LEN and OS_FRAME_DELIM the
+ * spans describe the payload; for OS_FRAME_SLIP and OS_FRAME_COBS they describe the still
+ * encoded frame (without the terminator). Call os_frame_consume() once done with the frame.
+ *
+ * @param[out] spans
+ * 		Caller-provided array of two spans describing the frame.
+ *
+ * @param[out] p_len
+ * 		Total length of the spans. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN		-	No complete frame yet
+ * 		OS_EOVERFLOW	-	Frame exceeds max_len or the ring buffer capacity (consume it to
+ * 							resynchronize; the rest of the frame is then dropped as it arrives)
+*/
+int os_frame_peek(os_frame_t *f, os_rbuf_t *rb, os_rbuf_span_t spans[2], uint32_t *p_len);
+
+/**
+ * Remove the frame located by os_frame_peek() (including its framing) from the ring buffer.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	No frame was located
+*/
+int os_frame_consume(os_frame_t *f, os_rbuf_t *rb);
+
+/**
+ * Extract, decode and remove the next complete frame into a caller-provided buffer.
+ *
+ * @param[out] p_buffer
+ * 		Caller-provided buffer to write the decoded payload to.
+ *
+ * @param[in] bufsize
+ * 		Size of p_buffer.
+ *
+ * @param[out] p_len
+ * 		Decoded payload length.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL		-	Invalid arguments or malformed frame (frame removed)
+ * 		OS_EAGAIN		-	No complete frame yet
+ * 		OS_EOVERFLOW	-	Frame exceeds max_len, the ring buffer capacity or bufsize (frame removed)
+*/
+int os_frame_decode(os_frame_t *f, os_rbuf_t *rb, uint8_t *p_buffer, uint32_t bufsize, uint32_t *p_len);
+
+#endif
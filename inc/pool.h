@@ -0,0 +1,189 @@
+#ifndef OS_POOL_H
+#define OS_POOL_H
+#include "mutex.h"
+#include "task.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Default per-worker job queue size (os_pool_init() with queue_size = 0) */
+#define OS_POOL_QUEUE_SIZE 1024U
+
+typedef void (*os_pool_job_f)(void *arg);
+
+/* Range function for os_pool_parallel_for(); processes [begin, end) */
+typedef void (*os_pool_range_f)(void *ctx, size_t begin, size_t end);
+
+/* Fork/join group; counts the group's jobs that have not finished yet */
+typedef struct os_pool_group_s
+{
+	struct os_pool_s *pool;
+
+	uint32_t pending;
+} os_pool_group_t;
+
+/* Queued job */
+typedef struct
+{
+	os_pool_job_f p_func;
+	void *p_func_arg;
+
+	/* Group the job belongs to (NULL for os_pool_submit() jobs) */
+	os_pool_group_t *group;
+} os_pool_job_t;
+
+/**
+ * Worker control block. Each worker owns a double-ended job queue: the worker takes its
+ * own newest jobs first (LIFO, cache-warm), idle workers steal the oldest ones (FIFO).
+*/
+typedef struct os_pool_worker_s
+{
+	os_task_t task;
+
+	struct os_pool_s *pool;
+
+	os_mutex_t mutex;
+
+	/* Job deque (power of 2 ring; head = steal end, tail = owner end) */
+	os_pool_job_t *jobs;
+	uint32_t size;
+	uint32_t head;
+	uint32_t tail;
+} os_pool_worker_t;
+
+/* Thread pool control block */
+typedef struct os_pool_s
+{
+	os_pool_worker_t *workers;
+	uint32_t count;
+
+	/* Worker used for the next submission from a non-worker thread */
+	uint32_t next;
+
+	/* Number of queued (not yet started) jobs; idle workers sleep on it while it is 0 */
+	uint32_t pending;
+	uint32_t sleepers;
+
+	/* Set by os_pool_destroy() */
+	uint32_t stopping;
+} os_pool_t;
+
+/**
+ * Create a pool of worker tasks. The workers are started immediately and exit when the
+ * pool is destroyed or the runtime is exiting.
+ *
+ * @param[in] p
+ * 		Pointer to os_pool_t object.
+ *
+ * @param[in] count
+ * 		Number of worker tasks (0 = one per online CPU).
+ *
+ * @param[in] queue_size
+ * 		Job queue size of each worker; rounded up to a power of 2 (0 = OS_POOL_QUEUE_SIZE).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOMEM
+ * 		OS_EERROR
+*/
+int os_pool_init(os_pool_t *p, uint32_t count, uint32_t queue_size);
+
+/**
+ * Stop and join all workers of a pool created using os_pool_init(). Jobs that have not
+ * started yet are discarded.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_pool_destroy(os_pool_t *p);
+
+/**
+ * Queue a job. When called from one of the pool's workers the job is queued on that
+ * worker (and run next by it unless stolen); otherwise workers are picked round-robin.
+ *
+ * @param[in] p_func
+ * 		Job function.
+ *
+ * @param[in] p_func_arg
+ * 		Argument passed to the job function. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Job queue is full
+*/
+int os_pool_submit(os_pool_t *p, os_pool_job_f p_func, void *p_func_arg);
+
+/**
+ * Number of queued jobs that have not started yet.
+*/
+uint32_t os_pool_pending(os_pool_t *p);
+
+/**
+ * Initialize a fork/join group on a pool.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_pool_group_init(os_pool_group_t *g, os_pool_t *p);
+
+/**
+ * Fork a job in a group. If every job queue is full the job is run inline by the caller,
+ * so a fork never fails for lack of queue space.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_pool_group_submit(os_pool_group_t *g, os_pool_job_f p_func, void *p_func_arg);
+
+/**
+ * Join a group: wait until all of its jobs have finished. The caller runs queued jobs
+ * while waiting, so groups can be nested inside jobs without deadlocking the pool, and
+ * sleeps once only running jobs are left.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_pool_group_wait(os_pool_group_t *g);
+
+/**
+ * Run p_func over [begin, end) in parallel and wait for completion. Workers (and the
+ * caller) repeatedly claim the next chunk of 'grain' indexes, so faster workers take more
+ * chunks and the load balances itself.
+ *
+ * @param[in] grain
+ * 		Number of indexes per chunk (0 = split into about 8 chunks per worker).
+ *
+ * @param[in] p_func
+ * 		Function called for every chunk with [chunk_begin, chunk_end).
+ *
+ * @param[in] ctx
+ * 		Caller provided argument passed to p_func. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_pool_parallel_for(os_pool_t *p, size_t begin, size_t end, size_t grain, os_pool_range_f p_func, void *ctx);
+
+#endif
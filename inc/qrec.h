@@ -0,0 +1,197 @@
+#ifndef OS_QREC_H
+#define OS_QREC_H
+#include "queue.h"
+
+#include <stdint.h>
+
+/* Recording file magic value ("OSQR") and format version */
+#define OS_QREC_MAGIC	(0x5251534FU)
+#define OS_QREC_VERSION	(1U)
+
+/* Record types */
+#define OS_QREC_TYPE_SEND (0U)
+#define OS_QREC_TYPE_POST (1U)
+
+/* Recording file header (written once at the start of the file) */
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+
+	/* CLOCK_MONOTONIC time (nanoseconds) the recording was opened */
+	uint64_t start_ns;
+} os_qrec_header_t;
+
+/* Record header; followed by 'nbytes' of payload and padded to 8 bytes */
+typedef struct
+{
+	/* Total record size in bytes; written last, 0 marks the end of the recording */
+	uint32_t size;
+
+	/* OS_QREC_TYPE_xxx value */
+	uint16_t type;
+
+	/* Number of used payload bytes following this header */
+	uint16_t nbytes;
+
+	/* CLOCK_MONOTONIC time (nanoseconds) the message was sent/posted */
+	uint64_t timestamp;
+
+	/* Addresses of the source and target queues in the recording process */
+	uint64_t source;
+	uint64_t target;
+
+	uint32_t userdata;
+	uint32_t id;
+} os_qrec_entry_t;
+
+/* Recorder control block */
+typedef struct os_qrec_s
+{
+	int fd;
+
+	uint8_t *map;
+	uint64_t capacity;
+
+	/* Append cursor (byte offset into the mapping) */
+	uint64_t offset;
+
+	/* Number of records dropped because the recording file was full */
+	uint64_t dropped;
+
+	/* Appends in progress, and set once os_qrec_close() waits for them to finish */
+	uint32_t writers;
+	uint32_t closing;
+} os_qrec_t;
+
+/**
+ * Map a caller's recorded queue address to a queue in the replaying process.
+ * Returning NULL skips the record.
+*/
+typedef os_queue_t *(*os_qrec_map_f)(uint64_t addr, void *arg);
+
+/**
+ * Create a new recording file and map it into memory. The file is truncated to
+ * the used length when the recorder is closed.
+ *
+ * @param[in] p
+ * 		Pointer to os_qrec_t object.
+ *
+ * @param[in] path
+ * 		Path of the recording file (created or truncated).
+ *
+ * @param[in] capacity
+ * 		Maximum size of the recording file in bytes.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT
+ * 		OS_ENOMEM
+ * 		OS_EERROR	-	File could not be sized (e.g. no space left)
+*/
+int os_qrec_open(os_qrec_t *p, const char *path, uint64_t capacity);
+
+/**
+ * Close a recorder opened using the os_qrec_open() function. The recorder is
+ * detached from the queue layer if it is still recording, and appends still in
+ * progress (including manual os_qrec_append() calls) finish before it is unmapped.
+ *
+ * @param[in] p
+ * 		Pointer to os_qrec_t object.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_qrec_close(os_qrec_t *p);
+
+/**
+ * Start recording every os_queue_send() and os_queue_post() call to the recorder.
+ * Only one recorder can be attached at a time.
+ *
+ * @param[in] p
+ * 		Pointer to os_qrec_t object.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN	-	Another recorder is already attached
+*/
+int os_qrec_start(os_qrec_t *p);
+
+/**
+ * Stop recording queue traffic to the recorder.
+ *
+ * @param[in] p
+ * 		Pointer to os_qrec_t object.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_qrec_stop(os_qrec_t *p);
+
+/**
+ * Append a message to the recording. Called by the queue layer while recording,
+ * but can also be used to record messages manually. The record is stamped with
+ * msg->timestamp (or the current time if it is 0).
+ *
+ * @param[in] p
+ * 		Pointer to os_qrec_t object.
+ *
+ * @param[in] type
+ * 		OS_QREC_TYPE_xxx value.
+ *
+ * @param[in] msg
+ * 		Message to record.
+ *
+ * @param[in] nbytes
+ * 		Number of used payload bytes in the message.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL		-	Invalid arguments or the recorder is being closed
+ * 		OS_EOVERFLOW	-	Recording file is full (record dropped)
+*/
+int os_qrec_append(os_qrec_t *p, uint16_t type, const os_msg_t *msg, uint32_t nbytes);
+
+/**
+ * Re-inject a recorded message stream into the queues. This function blocks until
+ * the recording has been replayed or the runtime is exiting.
+ *
+ * @param[in] path
+ * 		Path of the recording file.
+ *
+ * @param[in] speed
+ * 		Replay speed relative to the original timing (1.0 = original, 2.0 = twice as
+ * 		fast). A value of 0 replays the stream as fast as possible.
+ *
+ * @param[in] p_map
+ * 		Function mapping recorded queue addresses to live queues. If NULL, the recorded
+ * 		addresses are used as-is (replaying within the recording process).
+ *
+ * @param[in] p_map_arg
+ * 		Caller provided argument passed to p_map. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT
+ * 		OS_ENOMEM
+*/
+int os_qrec_replay(const char *path, double speed, os_qrec_map_f p_map, void *p_map_arg);
+
+#endif
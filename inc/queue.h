@@ -1,7 +1,9 @@
 #ifndef LIBOS_QUEUE_H
 #define LIBOS_QUEUE_H
+#include "bytes.h"
 #include "mutex.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define OS_QUEUE_MSGID_MAX (8192U)
@@ -11,6 +13,9 @@
 
 #define OS_QUEUE_PARAM_COUNT 128U
 
+/* Maximum length of an (optional) queue name */
+#define OS_QUEUE_NAME_SIZE 32U
+
 typedef struct os_queue_s os_queue_t;
 
 typedef struct
@@ -21,6 +26,9 @@ typedef struct
 
 	uint32_t id;
 
+	/* CLOCK_MONOTONIC time (nanoseconds) the message was queued */
+	uint64_t timestamp;
+
 	union
 	{
 		uint32_t params[OS_QUEUE_PARAM_COUNT];
@@ -30,18 +38,94 @@ typedef struct
 
 struct os_queue_s
 {
+	/* Read-mostly fields; only written on init/destroy */
 	os_queue_t *next;
 
 	os_msg_t *buffer;
-	uint32_t  head;
-	uint32_t  tail;
 	uint32_t  size;
 
-	uint32_t  subscriptions[OS_QUEUE_SUB_TABLE_SIZE];
+	/* Subscription table (one bit per message ID), allocated by os_queue_init(); only one word is read per post */
+	uint32_t *subscriptions;
+
+	/* Number of message IDs this queue is subscribed to */
+	uint32_t  sub_count;
+
+	/* Optional queue name (empty if not set) */
+	char name[OS_QUEUE_NAME_SIZE + 1U];
+
+	/* Padding keeps the cursors on cache lines of their own without requiring an aligned queue */
+	uint8_t   pad0[CACHE_LINE_SIZE];
+
+	/* Producer cursor; written by senders/posters */
+	uint32_t  tail;
+
+	uint8_t   pad1[CACHE_LINE_SIZE];
+
+	/* Consumer cursor; written by the receiving task */
+	uint32_t  head;
+
+	/* Keeps the consumer cursor off the cache line of whatever follows the queue */
+	uint8_t   pad2[CACHE_LINE_SIZE - sizeof(uint32_t)];
 };
 
+/* Point-in-time state of one queue, returned by os_queue_snapshot() */
+typedef struct
+{
+	const os_queue_t *queue;
+
+	char name[OS_QUEUE_NAME_SIZE + 1U];
+
+	/* Number of messages waiting */
+	uint32_t depth;
+
+	/* Maximum number of messages the queue can hold */
+	uint32_t capacity;
+
+	/* Number of message IDs the queue is subscribed to */
+	uint32_t sub_count;
+
+	/* Age of the oldest waiting message in nanoseconds (0 if empty) */
+	uint64_t oldest_age_ns;
+} os_queue_stat_t;
+
 int os_queue_init(os_queue_t *p, os_msg_t *p_msg_pool, uint32_t pool_size);
 int os_queue_destroy(os_queue_t *p);
+
+/**
+ * Set the (optional) name of a queue. Names are reported by os_queue_snapshot().
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_queue_set_name(os_queue_t *p, const char *name);
+
+/**
+ * Take a snapshot of every queue. The global queue lock is held only while copying
+ * a few fields of a small batch of queues, so sends and posts are never stalled behind
+ * the whole list. Batches are taken at slightly different times; queues created while
+ * the snapshot is taken are not reported, and destroying the queue the next batch starts
+ * at ends the snapshot early.
+ *
+ * @param[out] p_stats
+ * 		Caller-provided array to write queue states to.
+ *
+ * @param[in] max_count
+ * 		Number of entries in p_stats.
+ *
+ * @param[out] p_count
+ * 		Number of queues visited. Only the first max_count are written to p_stats.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_queue_snapshot(os_queue_stat_t *p_stats, uint32_t max_count, uint32_t *p_count);
+
 int os_queue_sub(os_queue_t *p, uint32_t id);
 int os_queue_unsub(os_queue_t *p, uint32_t id);
 int os_queue_send(os_queue_t *p, os_msg_t *msg);
@@ -50,4 +134,107 @@ int os_queue_recv(os_queue_t *p, os_msg_t *p_msg);
 int os_queue_post(os_queue_t *p, os_msg_t *msg);
 int os_queue_postv(os_queue_t *p, uint32_t id, uint32_t param_count, ...);
 
+/**
+ * Send a message with 'param_count' params. The header and params are written directly
+ * into the target queue's slot; params past 'param_count' are left unspecified.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Target queue not found
+*/
+int os_queue_sendn(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t param_count, const uint32_t *params);
+
+/**
+ * Post a message with 'param_count' params to all subscribed queues. The header and params
+ * are written directly into each subscriber's slot; params past 'param_count' are left unspecified.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_queue_postn(os_queue_t *p, uint32_t id, uint32_t param_count, const uint32_t *params);
+
+/* Typed, fixed-arity senders (no varargs; params are type checked by the compiler) */
+
+static inline int
+os_queue_send0(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id)
+{
+	return os_queue_sendn(p, dst, userdata, id, 0U, NULL);
+}
+
+static inline int
+os_queue_send1(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t p0)
+{
+	const uint32_t params[1U] = {p0};
+
+	return os_queue_sendn(p, dst, userdata, id, 1U, params);
+}
+
+static inline int
+os_queue_send2(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t p0, uint32_t p1)
+{
+	const uint32_t params[2U] = {p0, p1};
+
+	return os_queue_sendn(p, dst, userdata, id, 2U, params);
+}
+
+static inline int
+os_queue_send3(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t p0, uint32_t p1, uint32_t p2)
+{
+	const uint32_t params[3U] = {p0, p1, p2};
+
+	return os_queue_sendn(p, dst, userdata, id, 3U, params);
+}
+
+static inline int
+os_queue_send4(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3)
+{
+	const uint32_t params[4U] = {p0, p1, p2, p3};
+
+	return os_queue_sendn(p, dst, userdata, id, 4U, params);
+}
+
+static inline int
+os_queue_post0(os_queue_t *p, uint32_t id)
+{
+	return os_queue_postn(p, id, 0U, NULL);
+}
+
+static inline int
+os_queue_post1(os_queue_t *p, uint32_t id, uint32_t p0)
+{
+	const uint32_t params[1U] = {p0};
+
+	return os_queue_postn(p, id, 1U, params);
+}
+
+static inline int
+os_queue_post2(os_queue_t *p, uint32_t id, uint32_t p0, uint32_t p1)
+{
+	const uint32_t params[2U] = {p0, p1};
+
+	return os_queue_postn(p, id, 2U, params);
+}
+
+static inline int
+os_queue_post3(os_queue_t *p, uint32_t id, uint32_t p0, uint32_t p1, uint32_t p2)
+{
+	const uint32_t params[3U] = {p0, p1, p2};
+
+	return os_queue_postn(p, id, 3U, params);
+}
+
+static inline int
+os_queue_post4(os_queue_t *p, uint32_t id, uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3)
+{
+	const uint32_t params[4U] = {p0, p1, p2, p3};
+
+	return os_queue_postn(p, id, 4U, params);
+}
+
 #endif
@@ -1,16 +1,84 @@
 #ifndef OS_RBUF_H
 #define OS_RBUF_H
+#include <stdbool.h>
 #include <stdint.h>
 
+/* Pool is mapped twice back-to-back (see os_rbuf_mirror_init()) */
+#define OS_RBUF_F_MIRROR (1U << 0)
+
+/* Pushing to a full ring buffer discards the oldest data (see os_rbuf_set_overwrite()) */
+#define OS_RBUF_F_OVERWRITE (1U << 1)
+
 typedef struct
 {
 	uint8_t *pool;
 	uint32_t size;
 	uint32_t head;
 	uint32_t tail;
+	uint32_t flags;
+
+	/* Number of bytes discarded by pushes in overwrite mode */
+	uint64_t dropped;
 } os_rbuf_t;
 
+/* Contiguous region of a ring buffer's pool */
+typedef struct
+{
+	uint8_t *data;
+	uint32_t len;
+} os_rbuf_span_t;
+
 int os_rbuf_init(os_rbuf_t *p, uint8_t *p_pool, uint32_t pool_size);
+
+/**
+ * Initialize a ring buffer whose pool is mapped twice back-to-back in virtual memory,
+ * so any used or free region is contiguous starting at &pool[cursor]. os_rbuf_read_spans()
+ * and os_rbuf_write_spans() always return a single span for these ring buffers.
+ *
+ * @param[in] pool_size
+ * 		Size of the byte pool; must be a power of 2 and a multiple of the page size.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOMEM
+*/
+int os_rbuf_mirror_init(os_rbuf_t *p, uint32_t pool_size);
+
+/**
+ * Unmap the pool of a ring buffer created using os_rbuf_mirror_init().
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_mirror_destroy(os_rbuf_t *p);
+
+/**
+ * Enable or disable overwrite (lossy) mode. In overwrite mode os_rbuf_push() never fails
+ * with OS_EOVERFLOW; the oldest data is discarded to make room for the new bytes, and if
+ * more bytes than the capacity are pushed only the newest ones are kept.
+ *
+ * @param[in] enable
+ * 		True = discard the oldest data when full, False = fail with OS_EOVERFLOW.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_set_overwrite(os_rbuf_t *p, bool enable);
+
+/**
+ * Get the number of bytes discarded by pushes in overwrite mode since initialization or
+ * the last os_rbuf_flush().
+*/
+uint64_t os_rbuf_dropped(os_rbuf_t *p);
 int os_rbuf_change_size(os_rbuf_t *p, uint32_t pool_size);
 int os_rbuf_flush(os_rbuf_t *p);
 uint32_t os_rbuf_used(os_rbuf_t *p);
@@ -43,4 +111,185 @@ int os_rbuf_pop_u32(os_rbuf_t *p, uint32_t *p_value);
 int os_rbuf_pop_u64(os_rbuf_t *p, uint64_t *p_value);
 #endif
 
+/**
+ * Push an array of values in the selected byte order. The values are converted directly
+ * into the byte pool in one pass (no per-value function call).
+ *
+ * In overwrite mode (see os_rbuf_set_overwrite()) the oldest bytes are discarded like
+ * os_rbuf_push(); if the array is larger than the pool only the newest whole values are kept.
+ *
+ * @param[in] values
+ * 		Array of values to push.
+ *
+ * @param[in] count
+ * 		Number of values (not bytes).
+ *
+ * @param[in] big_endian
+ * 		True = big endian encoding, False = little endian.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Not enough free space for all values (nothing pushed, overwrite off)
+*/
+int os_rbuf_push_u16v(os_rbuf_t *p, const uint16_t *values, uint32_t count, bool big_endian);
+int os_rbuf_push_u32v(os_rbuf_t *p, const uint32_t *values, uint32_t count, bool big_endian);
+int os_rbuf_push_u64v(os_rbuf_t *p, const uint64_t *values, uint32_t count, bool big_endian);
+
+/**
+ * Decode an array of values (in the selected byte order) without removing them.
+ *
+ * @param[in] offset
+ * 		Byte offset (from the head of the used data) of the first value.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data for all values
+*/
+int os_rbuf_peek_u16v(os_rbuf_t *p, uint32_t offset, uint16_t *values, uint32_t count, bool big_endian);
+int os_rbuf_peek_u32v(os_rbuf_t *p, uint32_t offset, uint32_t *values, uint32_t count, bool big_endian);
+int os_rbuf_peek_u64v(os_rbuf_t *p, uint32_t offset, uint64_t *values, uint32_t count, bool big_endian);
+
+/**
+ * Decode and remove an array of values (in the selected byte order).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data for all values (nothing removed)
+*/
+int os_rbuf_pop_u16v(os_rbuf_t *p, uint16_t *values, uint32_t count, bool big_endian);
+int os_rbuf_pop_u32v(os_rbuf_t *p, uint32_t *values, uint32_t count, bool big_endian);
+int os_rbuf_pop_u64v(os_rbuf_t *p, uint64_t *values, uint32_t count, bool big_endian);
+
+/**
+ * Describe the readable (used) data as up to two contiguous regions, in order.
+ * The data can be parsed in place and released using os_rbuf_consume().
+ *
+ * @param[out] spans
+ * 		Caller-provided array of two spans. Unused spans are set to {NULL, 0}.
+ *
+ * @return Number of spans describing data (0, 1 or 2), -1 on invalid arguments.
+*/
+int os_rbuf_read_spans(os_rbuf_t *p, os_rbuf_span_t spans[2]);
+
+/**
+ * Describe the writable (free) space as up to two contiguous regions, in order.
+ * Data can be written in place and committed using os_rbuf_produce().
+ *
+ * @param[out] spans
+ * 		Caller-provided array of two spans. Unused spans are set to {NULL, 0}.
+ *
+ * @return Number of spans describing free space (0, 1 or 2), -1 on invalid arguments.
+*/
+int os_rbuf_write_spans(os_rbuf_t *p, os_rbuf_span_t spans[2]);
+
+/**
+ * Release 'count' bytes of readable data (advance the head cursor).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Less than 'count' bytes used
+*/
+int os_rbuf_consume(os_rbuf_t *p, uint32_t count);
+
+/**
+ * Commit 'count' bytes written into the write spans (advance the tail cursor).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Less than 'count' bytes free
+*/
+int os_rbuf_produce(os_rbuf_t *p, uint32_t count);
+
+/**
+ * Search the used data for a byte pattern, across the wrap boundary of the pool.
+ *
+ * @param[in] offset
+ * 		Offset (from the head of the used data) to start searching at.
+ *
+ * @param[in] pattern
+ * 		Byte pattern to search for.
+ *
+ * @param[in] pattern_len
+ * 		Length of the pattern in bytes.
+ *
+ * @param[out] p_pos
+ * 		Offset (from the head of the used data) of the first match.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Pattern not found
+*/
+int os_rbuf_find(os_rbuf_t *p, uint32_t offset, const uint8_t *pattern, uint32_t pattern_len, uint32_t *p_pos);
+
+/**
+ * Search the used data for a single byte (e.g. a delimiter). Same as os_rbuf_find()
+ * using a one byte pattern.
+*/
+int os_rbuf_find_u8(os_rbuf_t *p, uint32_t offset, uint8_t value, uint32_t *p_pos);
+
+/**
+ * Read from a file descriptor directly into the ring buffer's free space (one readv() call).
+ *
+ * @param[in] fd
+ * 		File descriptor to read from.
+ *
+ * @param[in] max
+ * 		Maximum number of bytes to read (0 = as many as fit).
+ *
+ * @param[out] p_count
+ * 		Number of bytes read; 0 indicates end-of-file. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Ring buffer is full
+ * 		OS_EAGAIN		-	Non-blocking descriptor has no data
+ * 		OS_EERROR		-	readv() failed
+*/
+int os_rbuf_read_fd(os_rbuf_t *p, int fd, uint32_t max, uint32_t *p_count);
+
+/**
+ * Write used data directly from the ring buffer to a file descriptor (one writev() call).
+ * Written bytes are removed from the ring buffer.
+ *
+ * @param[in] fd
+ * 		File descriptor to write to.
+ *
+ * @param[in] max
+ * 		Maximum number of bytes to write (0 = all used bytes).
+ *
+ * @param[out] p_count
+ * 		Number of bytes written. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Ring buffer is empty
+ * 		OS_EAGAIN	-	Non-blocking descriptor can't accept data
+ * 		OS_EERROR	-	writev() failed
+*/
+int os_rbuf_write_fd(os_rbuf_t *p, int fd, uint32_t max, uint32_t *p_count);
+
 #endif
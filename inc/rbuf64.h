@@ -0,0 +1,125 @@
+#ifndef OS_RBUF64_H
+#define OS_RBUF64_H
+#include <stdint.h>
+
+/**
+ * Byte ring buffer with free-running 64-bit cursors. Unlike os_rbuf_t the cursors are
+ * never masked when stored, so used = tail - head and the full power-of-2 pool can be
+ * filled. Pools larger than 4 GB are supported.
+*/
+typedef struct
+{
+	uint8_t *pool;
+
+	/* Pool size (power of 2) and cursor mask */
+	uint64_t size;
+	uint64_t mask;
+
+	/* Free-running cursors (total number of bytes popped/pushed) */
+	uint64_t head;
+	uint64_t tail;
+} os_rbuf64_t;
+
+/* Contiguous region of a 64-bit ring buffer's pool */
+typedef struct
+{
+	uint8_t *data;
+	uint64_t len;
+} os_rbuf64_span_t;
+
+/**
+ * Initialize a 64-bit ring buffer.
+ *
+ * @param[in] p
+ * 		Pointer to os_rbuf64_t object.
+ *
+ * @param[in] p_pool
+ * 		Caller-provided byte pool.
+ *
+ * @param[in] pool_size
+ * 		Size of the byte pool (must be a power of 2). All bytes are usable.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf64_init(os_rbuf64_t *p, uint8_t *p_pool, uint64_t pool_size);
+int os_rbuf64_flush(os_rbuf64_t *p);
+uint64_t os_rbuf64_used(os_rbuf64_t *p);
+uint64_t os_rbuf64_free(os_rbuf64_t *p);
+
+/**
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Not enough free space
+*/
+int os_rbuf64_push(os_rbuf64_t *p, const uint8_t *bytes, uint64_t nbytes);
+
+/**
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf64_peek(os_rbuf64_t *p, uint64_t offset, uint8_t *p_buffer, uint64_t count);
+
+/**
+ * @param[in] p_buffer
+ * 		User provided buffer to copy data to. If this parameter is NULL, the
+ * 		data will be popped from the buffer without copying.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf64_pop(os_rbuf64_t *p, uint8_t *p_buffer, uint64_t count);
+
+/**
+ * Describe the readable (used) data as up to two contiguous regions, in order.
+ *
+ * @return Number of spans describing data (0, 1 or 2), -1 on invalid arguments.
+*/
+int os_rbuf64_read_spans(os_rbuf64_t *p, os_rbuf64_span_t spans[2]);
+
+/**
+ * Describe the writable (free) space as up to two contiguous regions, in order.
+ *
+ * @return Number of spans describing free space (0, 1 or 2), -1 on invalid arguments.
+*/
+int os_rbuf64_write_spans(os_rbuf64_t *p, os_rbuf64_span_t spans[2]);
+
+/**
+ * Release 'count' bytes of readable data (advance the head cursor).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Less than 'count' bytes used
+*/
+int os_rbuf64_consume(os_rbuf64_t *p, uint64_t count);
+
+/**
+ * Commit 'count' bytes written into the write spans (advance the tail cursor).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Less than 'count' bytes free
+*/
+int os_rbuf64_produce(os_rbuf64_t *p, uint64_t count);
+
+#endif
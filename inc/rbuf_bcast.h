@@ -0,0 +1,156 @@
+#ifndef OS_RBUF_BCAST_H
+#define OS_RBUF_BCAST_H
+#include "bytes.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum number of readers attached to a broadcast ring buffer */
+#define OS_RBUF_BCAST_READERS_MAX (8U)
+
+/* Reader cursor (each on its own cache line) */
+typedef struct
+{
+	/* Free-running read cursor; written by the reader (and by the writer in lossy mode) */
+	uint64_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+
+	/* Number of bytes this reader missed because the writer overran it (lossy mode) */
+	uint64_t lost;
+
+	/* Slot owned by a reader (set first by os_rbuf_bcast_attach(), so attaches don't race) */
+	uint32_t claimed;
+
+	/* Published after the cursor; the writer only looks at active readers */
+	uint32_t active;
+} os_rbuf_bcast_reader_t;
+
+/**
+ * Lock-free single-writer/multi-reader broadcast byte ring buffer. Every byte pushed by
+ * the writer is seen by every attached reader; each reader has an independent cursor
+ * and can run in its own thread. The pool size must be a power of 2 and all of it is
+ * usable (cursors are free-running 64-bit counters, see os_rbuf64_t).
+ *
+ * By default the writer's free space is bounded by the slowest reader. In lossy mode
+ * the writer never waits; readers that fall more than a pool behind are moved forward
+ * and the skipped bytes are counted in their 'lost' counter.
+*/
+typedef struct
+{
+	/* Read-mostly fields; only written by os_rbuf_bcast_init() */
+	uint8_t *pool;
+	uint64_t size;
+	uint64_t mask;
+	bool lossy;
+
+	/* Writer-owned cursor and the writer's cached copy of the slowest reader cursor */
+	uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint64_t head_cache;
+
+	os_rbuf_bcast_reader_t readers[OS_RBUF_BCAST_READERS_MAX];
+} os_rbuf_bcast_t;
+
+/**
+ * Initialize a broadcast ring buffer.
+ *
+ * @param[in] p
+ * 		Pointer to os_rbuf_bcast_t object.
+ *
+ * @param[in] p_pool
+ * 		Caller-provided byte pool.
+ *
+ * @param[in] pool_size
+ * 		Size of the byte pool (must be a power of 2).
+ *
+ * @param[in] lossy
+ * 		True = overrun lagging readers, False = the writer is limited by the slowest reader.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_bcast_init(os_rbuf_bcast_t *p, uint8_t *p_pool, uint64_t pool_size, bool lossy);
+
+/**
+ * Attach a new reader. The reader sees data pushed after it was attached. Must not be
+ * called concurrently with os_rbuf_bcast_push().
+ *
+ * @param[out] p_reader
+ * 		Reader index passed to the reader functions.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	OS_RBUF_BCAST_READERS_MAX readers already attached
+*/
+int os_rbuf_bcast_attach(os_rbuf_bcast_t *p, uint32_t *p_reader);
+
+/**
+ * Detach a reader; the writer no longer waits for it. Can be called at any time.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_bcast_detach(os_rbuf_bcast_t *p, uint32_t reader);
+
+/**
+ * Number of bytes the writer can push without failing (writer thread only). Always the
+ * pool size in lossy mode.
+*/
+uint64_t os_rbuf_bcast_free(os_rbuf_bcast_t *p);
+
+/**
+ * Push bytes to all readers (writer thread only). Data pushed while no reader is
+ * attached is discarded.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	The slowest reader has not made enough room (nothing pushed)
+*/
+int os_rbuf_bcast_push(os_rbuf_bcast_t *p, const uint8_t *bytes, uint64_t nbytes);
+
+/**
+ * Number of bytes available to a reader.
+*/
+uint64_t os_rbuf_bcast_used(os_rbuf_bcast_t *p, uint32_t reader);
+
+/**
+ * Copy bytes without removing them (owning reader thread only).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf_bcast_peek(os_rbuf_bcast_t *p, uint32_t reader, uint64_t offset, uint8_t *p_buffer, uint64_t count);
+
+/**
+ * Remove bytes from a reader's view (owning reader thread only). If p_buffer is NULL,
+ * the data is discarded without copying.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf_bcast_pop(os_rbuf_bcast_t *p, uint32_t reader, uint8_t *p_buffer, uint64_t count);
+
+/**
+ * Number of bytes a reader missed because the writer overran it (lossy mode).
+*/
+uint64_t os_rbuf_bcast_lost(os_rbuf_bcast_t *p, uint32_t reader);
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef OS_RBUF_SPSC_H
+#define OS_RBUF_SPSC_H
+#include "bytes.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Lock-free single-producer/single-consumer byte ring buffer. One thread may push
+ * while another pops/peeks without any external locking. The pool size must be a
+ * power of 2; one byte of the pool is kept unused (same as os_rbuf_t).
+*/
+typedef struct
+{
+	/* Read-mostly fields; only written by os_rbuf_spsc_init() */
+	uint8_t *pool;
+	uint32_t size;
+
+	/* Set by os_rbuf_spsc_init_waitable(); push/pop only check for waiters when set */
+	bool waitable;
+
+	/* Number of threads blocked in os_rbuf_spsc_wait_used()/os_rbuf_spsc_wait_free() */
+	uint32_t used_waiters;
+	uint32_t free_waiters;
+
+	/* Producer-owned cursor and the producer's cached copy of the consumer cursor */
+	uint32_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint32_t head_cache;
+
+	/* Consumer-owned cursor and the consumer's cached copy of the producer cursor */
+	uint32_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+	uint32_t tail_cache;
+} os_rbuf_spsc_t;
+
+/**
+ * Initialize a SPSC ring buffer.
+ *
+ * @param[in] p
+ * 		Pointer to os_rbuf_spsc_t object.
+ *
+ * @param[in] p_pool
+ * 		Caller-provided byte pool.
+ *
+ * @param[in] pool_size
+ * 		Size of the byte pool (must be a power of 2).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_spsc_init(os_rbuf_spsc_t *p, uint8_t *p_pool, uint32_t pool_size);
+
+/**
+ * Initialize a SPSC ring buffer that supports os_rbuf_spsc_wait_used() and
+ * os_rbuf_spsc_wait_free(). Push and pop on such a ring order the cursor update before
+ * the waiter check (a full barrier); rings created by os_rbuf_spsc_init() skip it.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_rbuf_spsc_init_waitable(os_rbuf_spsc_t *p, uint8_t *p_pool, uint32_t pool_size);
+
+/**
+ * Discard all data. Must not be called while the producer or consumer is active.
+*/
+int os_rbuf_spsc_flush(os_rbuf_spsc_t *p);
+
+/**
+ * Number of bytes available to the consumer. Exact when called from the consumer,
+ * a lower bound of the used bytes otherwise.
+*/
+uint32_t os_rbuf_spsc_used(os_rbuf_spsc_t *p);
+
+/**
+ * Number of bytes available to the producer. Exact when called from the producer,
+ * a lower bound of the free bytes otherwise.
+*/
+uint32_t os_rbuf_spsc_free(os_rbuf_spsc_t *p);
+
+/**
+ * Push bytes (producer thread only).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	Not enough free space (nothing pushed)
+*/
+int os_rbuf_spsc_push(os_rbuf_spsc_t *p, const uint8_t *bytes, uint32_t nbytes);
+
+/**
+ * Copy bytes without removing them (consumer thread only).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf_spsc_peek(os_rbuf_spsc_t *p, uint32_t offset, uint8_t *p_buffer, uint32_t count);
+
+/**
+ * Remove bytes (consumer thread only). If p_buffer is NULL, the data is discarded
+ * without copying.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Not enough data
+*/
+int os_rbuf_spsc_pop(os_rbuf_spsc_t *p, uint8_t *p_buffer, uint32_t count);
+
+/**
+ * Block until at least 'count' bytes are available to the consumer (consumer thread only).
+ * The consumer sleeps on the tail cursor and is woken by os_rbuf_spsc_push(); producers
+ * only make the wake-up system call while a consumer is waiting.
+ * On an os_task_t thread the wait also ends when os_task_stop() is called for the task.
+ *
+ * @param[in] count
+ * 		Number of bytes to wait for (at most the capacity of the ring buffer).
+ *
+ * @param[in] timeout_ms
+ * 		Maximum time to wait in milliseconds (0 = don't block, negative = wait forever).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN	-	Timed out or calling task asked to stop
+ * 		OS_ENOSUP	-	Ring not created by os_rbuf_spsc_init_waitable()
+*/
+int os_rbuf_spsc_wait_used(os_rbuf_spsc_t *p, uint32_t count, long timeout_ms);
+
+/**
+ * Block until at least 'count' bytes can be pushed (producer thread only). The producer
+ * sleeps on the head cursor and is woken by os_rbuf_spsc_pop().
+ * On an os_task_t thread the wait also ends when os_task_stop() is called for the task.
+ *
+ * @param[in] count
+ * 		Number of bytes to wait for (at most the capacity of the ring buffer).
+ *
+ * @param[in] timeout_ms
+ * 		Maximum time to wait in milliseconds (0 = don't block, negative = wait forever).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN	-	Timed out or calling task asked to stop
+ * 		OS_ENOSUP	-	Ring not created by os_rbuf_spsc_init_waitable()
+*/
+int os_rbuf_spsc_wait_free(os_rbuf_spsc_t *p, uint32_t count, long timeout_ms);
+
+#endif
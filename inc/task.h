@@ -2,28 +2,127 @@
 #define OS_TASK_H
 #include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef void* (*os_task_func_f)(void *param);
 
 #define OS_TASK_NAME_SIZE 64U
 
+/* Highest CPU index (exclusive) that can be part of a task's CPU set */
+#define OS_TASK_CPU_MAX 256U
+
+/* Task creation attributes (see os_task_attr_init()) */
+typedef struct
+{
+	/* CPUs the task may run on (bit N = CPU N); all zero = inherit the creator's set */
+	uint64_t cpus[OS_TASK_CPU_MAX / 64U];
+
+	/* Scheduling policy (SCHED_OTHER, SCHED_FIFO, SCHED_RR) and priority */
+	int policy;
+	int priority;
+
+	/* Stack and guard sizes in bytes (0 = system default) */
+	size_t stack_size;
+	size_t guard_size;
+} os_task_attr_t;
+
+/* Periodic task cycle function (see os_task_init_periodic()) */
+typedef void (*os_task_cycle_f)(void *param);
+
+/* What a periodic task does after missing one or more release times */
+typedef enum
+{
+	/* Drop the missed cycles and continue at the next future release time */
+	OS_TASK_MISS_SKIP = 0,
+
+	/* Run the missed cycles back to back until the task is on schedule again */
+	OS_TASK_MISS_CATCHUP = 1
+} OS_TASK_MISS;
+
+/* Periodic task statistics (see os_task_period_stats()) */
+typedef struct
+{
+	/* Cycles run */
+	uint64_t cycles;
+
+	/* Cycles that finished after their deadline */
+	uint64_t overruns;
+
+	/* Release times dropped by OS_TASK_MISS_SKIP */
+	uint64_t skipped;
+
+	/* Jitter: delay from a cycle's release time to the cycle start (nanoseconds) */
+	uint64_t jitter_min_ns;
+	uint64_t jitter_max_ns;
+	uint64_t jitter_avg_ns;
+
+	/* Longest and latest cycle execution time (nanoseconds) */
+	uint64_t exec_max_ns;
+	uint64_t exec_last_ns;
+} os_task_period_stats_t;
+
+/* Periodic task state */
+typedef struct
+{
+	os_task_cycle_f p_func;
+	void *p_func_arg;
+
+	uint64_t period_ns;
+	uint64_t deadline_ns;
+
+	OS_TASK_MISS miss;
+
+	/* Sequence counter guarding stats (odd while the task thread updates them) */
+	uint32_t seq;
+
+	os_task_period_stats_t stats;
+} os_task_period_t;
+
 /* Task control block */
 typedef struct os_task_s
 {
-	pthread_mutex_t mutex;
-
 	pthread_t thread;
 
-	uint32_t f_exiting:1U;
+	/* Stop request word (0 = run, 1 = stop); read atomically, futex waiters woken on change */
+	uint32_t stop;
+
+	/* eventfd signalled on stop (created on demand by os_task_stop_fd(), -1 until then) */
+	int stop_fd;
 
 	char name[OS_TASK_NAME_SIZE + 1U];
 
 	os_task_func_f p_func;
 
 	void *p_func_arg;
+
+	/* Kernel thread ID (set by the task thread when it starts, 0 until then) */
+	int32_t tid;
+
+	/* Heartbeat counter advanced by os_task_heartbeat(), checked by os_watchdog_t */
+	uint64_t heartbeat;
+
+	/* Periodic task state (unused unless created by os_task_init_periodic()) */
+	os_task_period_t period;
 } os_task_t;
 
+/* Task CPU and scheduling statistics (see os_task_stats()) */
+typedef struct
+{
+	/* CPU time consumed by the task thread (nanoseconds) */
+	uint64_t cpu_ns;
+
+	/* Context switches because the task blocked / was preempted */
+	uint64_t voluntary_switches;
+	uint64_t involuntary_switches;
+
+	/* CPU the task last ran on */
+	int32_t last_cpu;
+
+	/* Kernel thread ID (as shown by top -H, perf, /proc/<pid>/task) */
+	int32_t tid;
+} os_task_stats_t;
+
 /**
  * Create a new os_task_t object. The task is started immediately.
  * 
@@ -35,11 +134,113 @@ typedef struct os_task_s
  * 
  * @return -1 (os_errno set)
  * 		OS_EINVAL
- * 		OS_EMUTEX
+ * 		OS_EPERM	-	Not permitted to use the scheduling policy/priority
  * 		OS_EERROR
 */
 int os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg);
 
+/**
+ * Initialize task attributes to the defaults: any CPU, SCHED_OTHER, default stack.
+ *
+ * @param[in] attr
+ * 		Pointer to os_task_attr_t object.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_task_attr_init(os_task_attr_t *attr);
+
+/**
+ * Add a CPU to the set of CPUs the task may run on.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_task_attr_set_cpu(os_task_attr_t *attr, uint32_t cpu);
+
+/**
+ * Create a new os_task_t object with explicit attributes. CPU affinity, scheduling policy,
+ * priority and stack settings are applied by pthread_create(), so the task never runs
+ * with the creator's settings.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @param[in] attr
+ * 		Task attributes. If NULL, this is the same as os_task_init().
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EPERM	-	Not permitted to use the scheduling policy/priority
+ * 		OS_EERROR
+*/
+int os_task_init_ex(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg, const os_task_attr_t *attr);
+
+/**
+ * Create a task that calls p_func once per period. Release times are absolute
+ * (CLOCK_MONOTONIC), so a slow cycle does not shift the following ones, and the task
+ * sleeps in os_task_wait_stop() style so a stop request ends the sleep immediately.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @param[in] p_func
+ * 		Cycle function, called once per period until the task is stopped.
+ *
+ * @param[in] p_func_arg
+ * 		Argument passed to the cycle function. This value can be left NULL.
+ *
+ * @param[in] period_us
+ * 		Period in microseconds.
+ *
+ * @param[in] deadline_us
+ * 		Time after each release by which the cycle must finish, counted as an overrun
+ * 		otherwise (0 = the period).
+ *
+ * @param[in] miss
+ * 		Handling of release times missed because of overruns.
+ *
+ * @param[in] attr
+ * 		Task attributes. This value can be left NULL.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EPERM	-	Not permitted to use the scheduling policy/priority
+ * 		OS_EERROR
+*/
+int os_task_init_periodic(os_task_t *p, const char *name, os_task_cycle_f p_func, void *p_func_arg,
+						  long period_us, long deadline_us, OS_TASK_MISS miss, const os_task_attr_t *attr);
+
+/**
+ * Get a consistent snapshot of a periodic task's statistics. Can be called from any
+ * thread while the task runs.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object created by os_task_init_periodic().
+ *
+ * @param[out] p_stats
+ * 		Statistics of the task.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_task_period_stats(os_task_t *p, os_task_period_stats_t *p_stats);
+
 /**
  * Destroy a os_task_t initialized using the os_task_init() function.
  * The task will be stopped if currently running.
@@ -56,7 +257,29 @@ int os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_
 int os_task_destroy(os_task_t *p);
 
 /**
- * Check if the task should exit.
+ * Get the CPU time, context switch counts and last CPU of a task. The kernel thread
+ * name is set to the task name (truncated to 15 characters) when the task starts, so
+ * the statistics can be matched with top/perf output.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @param[out] p_stats
+ * 		Statistics of the task.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EAGAIN	-	Task thread has not started yet
+ * 		OS_ENOENT	-	Task thread has exited
+*/
+int os_task_stats(os_task_t *p, os_task_stats_t *p_stats);
+
+/**
+ * Check if the task should exit. This is a single atomic load and can be called in
+ * the task's inner loops.
  * 
  * @param[in] p
  * 		Pointer to os_task_t object.
@@ -66,4 +289,68 @@ int os_task_destroy(os_task_t *p);
 */
 bool os_task_check_stop(os_task_t *p);
 
+/**
+ * Ask a task to exit without waiting for it. Wakes the task if it is blocked in
+ * os_task_wait_stop(), polling its os_task_stop_fd() or sleeping in a library wait
+ * (os_rbuf_spsc_wait_used()/os_rbuf_spsc_wait_free(), idle os_pool_t workers). Other
+ * blocking calls (mutexes, queues, plain system calls) are not interrupted; use the stop
+ * fd or timeouts there. Called by os_task_destroy().
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_task_stop(os_task_t *p);
+
+/**
+ * Signal that the task is making progress. Call from the task's own loop; a task
+ * registered with a watchdog (see os_watchdog_add()) is reported as stalled when its
+ * heartbeat does not advance within the budget. Periodic tasks beat once per cycle.
+ *
+ * Only the task thread writes the counter, so this is a relaxed atomic load and store
+ * (no read-modify-write); the watchdog reads it with a relaxed load.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+*/
+static inline void
+os_task_heartbeat(os_task_t *p)
+{
+	__atomic_store_n(&p->heartbeat, __atomic_load_n(&p->heartbeat, __ATOMIC_RELAXED) + 1U, __ATOMIC_RELAXED);
+}
+
+/**
+ * Sleep until the task is asked to stop or the timeout expires. Use instead of
+ * os_sleep_ms() in task loops so shutdown is not delayed by the sleep.
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @param[in] timeout_ms
+ * 		Maximum time to sleep in milliseconds (negative = until stopped).
+ *
+ * @return bool
+ * 		True if the task should exit, false if the timeout expired.
+*/
+bool os_task_wait_stop(os_task_t *p, long timeout_ms);
+
+/**
+ * Get an eventfd that becomes readable once the task is asked to stop, for tasks
+ * blocked in poll()/epoll_wait() on other descriptors. The descriptor is owned by
+ * the task and closed by os_task_destroy().
+ *
+ * @param[in] p
+ * 		Pointer to os_task_t object.
+ *
+ * @return File descriptor, -1 on error (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EERROR
+*/
+int os_task_stop_fd(os_task_t *p);
+
 #endif
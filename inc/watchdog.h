@@ -0,0 +1,145 @@
+#ifndef OS_WATCHDOG_H
+#define OS_WATCHDOG_H
+#include "log.h"
+#include "mutex.h"
+#include "queue.h"
+#include "task.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Maximum number of tasks monitored by one watchdog */
+#define OS_WATCHDOG_TASKS_MAX 64U
+
+/* Monitored task */
+typedef struct
+{
+	os_task_t *task;
+
+	/* Maximum time between heartbeats before the task is reported as stalled */
+	uint64_t budget_ns;
+
+	/* Heartbeat value last seen, and when it last changed (CLOCK_MONOTONIC, ns) */
+	uint64_t heartbeat;
+	uint64_t changed_ns;
+
+	/* Set while the task is reported as stalled */
+	bool stalled;
+} os_watchdog_entry_t;
+
+/**
+ * Watchdog control block. A monitor task samples the heartbeat of every registered task
+ * (see os_task_heartbeat()) and reports tasks whose heartbeat has not advanced within
+ * their budget, and again when they recover.
+ *
+ * Reports are written to the log as warnings and/or posted to the queue's subscribers
+ * as message 'msg_id' with params:
+ * 		[0] Kernel thread ID of the task (0 if it has not started)
+ * 		[1] Milliseconds since the last heartbeat
+ * 		[2] 1 = stalled, 0 = recovered
+*/
+typedef struct
+{
+	os_task_t monitor;
+
+	os_mutex_t mutex;
+
+	os_watchdog_entry_t entries[OS_WATCHDOG_TASKS_MAX];
+	uint32_t count;
+
+	long interval_ms;
+
+	os_log_t *log;
+
+	os_queue_t *queue;
+	uint32_t msg_id;
+
+	/* Number of stalls detected */
+	uint64_t stalls;
+} os_watchdog_t;
+
+/**
+ * Create a watchdog and start its monitor task.
+ *
+ * @param[in] p
+ * 		Pointer to os_watchdog_t object.
+ *
+ * @param[in] interval_ms
+ * 		Time between heartbeat checks in milliseconds. Stalls are detected within
+ * 		budget + interval.
+ *
+ * @param[in] log
+ * 		Log to report stalls to. This value can be left NULL.
+ *
+ * @param[in] queue
+ * 		Queue used as the source of stall messages. This value can be left NULL.
+ *
+ * @param[in] msg_id
+ * 		Message ID of stall messages (ignored if queue is NULL).
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EMUTEX
+ * 		OS_EERROR
+*/
+int os_watchdog_init(os_watchdog_t *p, long interval_ms, os_log_t *log, os_queue_t *queue, uint32_t msg_id);
+
+/**
+ * Stop the monitor task and destroy a watchdog created using os_watchdog_init().
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+*/
+int os_watchdog_destroy(os_watchdog_t *p);
+
+/**
+ * Start monitoring a task. The budget is counted from the call, so the task has one
+ * budget to produce its first heartbeat.
+ *
+ * @param[in] task
+ * 		Task to monitor; must be removed before it is destroyed.
+ *
+ * @param[in] budget_ms
+ * 		Maximum time between heartbeats in milliseconds; must cover the longest
+ * 		legitimate wait in the task's loop.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_EOVERFLOW	-	OS_WATCHDOG_TASKS_MAX tasks already monitored
+ * 		OS_EMUTEX
+*/
+int os_watchdog_add(os_watchdog_t *p, os_task_t *task, long budget_ms);
+
+/**
+ * Stop monitoring a task.
+ *
+ * @return 0
+ * 		Success
+ *
+ * @return -1 (os_errno set)
+ * 		OS_EINVAL
+ * 		OS_ENOENT	-	Task is not monitored
+ * 		OS_EMUTEX
+*/
+int os_watchdog_remove(os_watchdog_t *p, os_task_t *task);
+
+/**
+ * Check if a monitored task is currently reported as stalled.
+*/
+bool os_watchdog_stalled(os_watchdog_t *p, os_task_t *task);
+
+/**
+ * Number of stalls detected since the watchdog was created.
+*/
+uint64_t os_watchdog_stalls(os_watchdog_t *p);
+
+#endif
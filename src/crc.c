@@ -0,0 +1,259 @@
+#include "../inc/crc.h"
+#include "../inc/rbuf.h"
+#include "../inc/errno.h"
+
+#include "private.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+/* CRC32C (Castagnoli) polynomial, reflected */
+#define CRC32C_POLY		0x82F63B78U
+
+/* CRC16-CCITT polynomial */
+#define CRC16_POLY		0x1021U
+
+/* Lookup tables, built on first use */
+static pthread_once_t g_crc_once = PTHREAD_ONCE_INIT;
+static uint32_t g_crc32c_table[8U][256U];
+static uint16_t g_crc16_table[256U];
+
+/* ------------------------------------------------------------ */
+
+static void
+os_crc_init_tables()
+{
+	for (uint32_t i = 0U; i < 256U; i++)
+	{
+		uint32_t c32 = i;
+		uint16_t c16 = (uint16_t)(i << 8U);
+
+		for (uint32_t bit = 0U; bit < 8U; bit++)
+		{
+			c32 = (c32 & 1U) ? (c32 >> 1U) ^ CRC32C_POLY : (c32 >> 1U);
+			c16 = (c16 & 0x8000U) ? (uint16_t)((c16 << 1U) ^ CRC16_POLY) : (uint16_t)(c16 << 1U);
+		}
+
+		g_crc32c_table[0U][i] = c32;
+		g_crc16_table[i]	  = c16;
+	}
+
+	/* Slice-by-8: table k advances a byte through k additional zero bytes */
+	for (uint32_t k = 1U; k < 8U; k++)
+	{
+		for (uint32_t i = 0U; i < 256U; i++)
+		{
+			uint32_t c = g_crc32c_table[k - 1U][i];
+
+			g_crc32c_table[k][i] = (c >> 8U) ^ g_crc32c_table[0U][c & 0xFFU];
+		}
+	}
+}
+
+static uint32_t
+os_crc32c_sw(uint32_t crc, const uint8_t *data, size_t len)
+{
+	/* Process 8 bytes per iteration using the slice-by-8 tables */
+	while (len >= 8U)
+	{
+		uint32_t lo = crc ^ ((uint32_t) data[0U] | ((uint32_t) data[1U] << 8U) |
+							 ((uint32_t) data[2U] << 16U) | ((uint32_t) data[3U] << 24U));
+		uint32_t hi = ((uint32_t) data[4U] | ((uint32_t) data[5U] << 8U) |
+					   ((uint32_t) data[6U] << 16U) | ((uint32_t) data[7U] << 24U));
+
+		crc = g_crc32c_table[7U][lo & 0xFFU] ^ g_crc32c_table[6U][(lo >> 8U) & 0xFFU] ^
+			  g_crc32c_table[5U][(lo >> 16U) & 0xFFU] ^ g_crc32c_table[4U][lo >> 24U] ^
+			  g_crc32c_table[3U][hi & 0xFFU] ^ g_crc32c_table[2U][(hi >> 8U) & 0xFFU] ^
+			  g_crc32c_table[1U][(hi >> 16U) & 0xFFU] ^ g_crc32c_table[0U][hi >> 24U];
+
+		data += 8U;
+		len	 -= 8U;
+	}
+
+	while (len--)
+		crc = (crc >> 8U) ^ g_crc32c_table[0U][(crc ^ *data++) & 0xFFU];
+
+	return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+static uint32_t
+os_crc32c_hw(uint32_t crc, const uint8_t *data, size_t len)
+{
+	uint64_t crc64 = crc;
+
+	/* One crc32 instruction per 8 bytes */
+	while (len >= 8U)
+	{
+		uint64_t word;
+
+		memcpy(&word, data, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+
+		data += 8U;
+		len	 -= 8U;
+	}
+
+	crc = (uint32_t) crc64;
+
+	while (len--)
+		crc = _mm_crc32_u8(crc, *data++);
+
+	return crc;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+static uint32_t
+os_crc32c_hw(uint32_t crc, const uint8_t *data, size_t len)
+{
+	/* One crc32cx instruction per 8 bytes */
+	while (len >= 8U)
+	{
+		uint64_t word;
+
+		memcpy(&word, data, sizeof(word));
+		crc = __crc32cd(crc, word);
+
+		data += 8U;
+		len	 -= 8U;
+	}
+
+	while (len--)
+		crc = __crc32cb(crc, *data++);
+
+	return crc;
+}
+
+#endif
+
+uint32_t
+os_crc32c(uint32_t crc, const uint8_t *data, size_t len)
+{
+	if (NULL == data || 0U == len)
+		return crc;
+
+	crc = ~crc;
+
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("sse4.2"))
+		return ~os_crc32c_hw(crc, data, len);
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+	return ~os_crc32c_hw(crc, data, len);
+#endif
+
+	pthread_once(&g_crc_once, os_crc_init_tables);
+
+	return ~os_crc32c_sw(crc, data, len);
+}
+
+uint16_t
+os_crc16_ccitt(uint16_t crc, const uint8_t *data, size_t len)
+{
+	if (NULL == data || 0U == len)
+		return crc;
+
+	pthread_once(&g_crc_once, os_crc_init_tables);
+
+	while (len--)
+		crc = (uint16_t)((crc << 8U) ^ g_crc16_table[((crc >> 8U) ^ *data++) & 0xFFU]);
+
+	return crc;
+}
+
+static int
+os_rbuf_crc_spans(os_rbuf_t *p, uint32_t offset, uint32_t len, os_rbuf_span_t spans[2])
+{
+	os_rbuf_span_t all[2];
+
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Ensure the byte pool has enough data to read (from the desired offset) */
+	if (os_rbuf_used(p) < (uint64_t) offset + len)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	os_rbuf_read_spans(p, all);
+
+	/* Cut the [offset, offset + len) region out of the used data */
+	for (uint32_t i = 0U; i < 2U; i++)
+	{
+		uint32_t skip = (offset < all[i].len) ? offset : all[i].len;
+		uint32_t n	  = ((all[i].len - skip) < len) ? (all[i].len - skip) : len;
+
+		spans[i] = (os_rbuf_span_t){ all[i].data + skip, n };
+
+		offset -= skip;
+		len	   -= n;
+	}
+
+	return 0;
+}
+
+int
+os_rbuf_crc32c(os_rbuf_t *p, uint32_t offset, uint32_t len, uint32_t seed, uint32_t *p_crc)
+{
+	os_rbuf_span_t spans[2];
+
+	if (NULL == p_crc)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_rbuf_crc_spans(p, offset, len, spans))
+		return -1;
+
+	seed = os_crc32c(seed, spans[0].data, spans[0].len);
+	seed = os_crc32c(seed, spans[1].data, spans[1].len);
+
+	*p_crc = seed;
+
+	return 0;
+}
+
+int
+os_rbuf_crc16(os_rbuf_t *p, uint32_t offset, uint32_t len, uint16_t seed, uint16_t *p_crc)
+{
+	os_rbuf_span_t spans[2];
+
+	if (NULL == p_crc)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_rbuf_crc_spans(p, offset, len, spans))
+		return -1;
+
+	seed = os_crc16_ccitt(seed, spans[0].data, spans[0].len);
+	seed = os_crc16_ccitt(seed, spans[1].data, spans[1].len);
+
+	*p_crc = seed;
+
+	return 0;
+}
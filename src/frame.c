@@ -0,0 +1,573 @@
+#include "../inc/frame.h"
+#include "../inc/rbuf.h"
+#include "../inc/errno.h"
+#include "../inc/bytes.h"
+
+#include "private.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* SLIP special characters (RFC 1055) */
+#define SLIP_END		0xC0U
+#define SLIP_ESC		0xDBU
+#define SLIP_ESC_END	0xDCU
+#define SLIP_ESC_ESC	0xDDU
+
+/* COBS frame delimiter */
+#define COBS_END		0x00U
+
+/* ------------------------------------------------------------ */
+
+static int
+os_frame_init(os_frame_t *f, OS_FRAME_TYPE type, uint32_t max_len)
+{
+	if (NULL == f)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out decoder memory */
+	memset(f, 0, sizeof(*f));
+
+	f->type	   = type;
+	f->max_len = max_len;
+
+	return 0;
+}
+
+int
+os_frame_init_len(os_frame_t *f, uint8_t width, bool big_endian, bool inclusive, uint32_t max_len)
+{
+	if (1U != width && 2U != width && 4U != width)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_frame_init(f, OS_FRAME_LEN, max_len))
+		return -1;
+
+	f->len_width	  = width;
+	f->len_big_endian = big_endian;
+	f->len_inclusive  = inclusive;
+
+	return 0;
+}
+
+int
+os_frame_init_delim(os_frame_t *f, const uint8_t *delim, uint32_t delim_len, uint32_t max_len)
+{
+	if (NULL == delim || 0U == delim_len || delim_len > OS_FRAME_DELIM_MAX)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_frame_init(f, OS_FRAME_DELIM, max_len))
+		return -1;
+
+	memcpy(f->delim, delim, delim_len);
+	f->delim_len = delim_len;
+
+	return 0;
+}
+
+int
+os_frame_init_slip(os_frame_t *f, uint32_t max_len)
+{
+	if (-1 == os_frame_init(f, OS_FRAME_SLIP, max_len))
+		return -1;
+
+	f->delim[0U] = SLIP_END;
+	f->delim_len = 1U;
+
+	return 0;
+}
+
+int
+os_frame_init_cobs(os_frame_t *f, uint32_t max_len)
+{
+	if (-1 == os_frame_init(f, OS_FRAME_COBS, max_len))
+		return -1;
+
+	f->delim[0U] = COBS_END;
+	f->delim_len = 1U;
+
+	return 0;
+}
+
+void
+os_frame_reset(os_frame_t *f)
+{
+	if (NULL == f)
+		return;
+
+	f->scanned			= 0U;
+	f->frame_len		= 0U;
+	f->frame_skip		= 0U;
+	f->frame_skip_delim = false;
+	f->skip				= 0U;
+	f->skip_delim		= false;
+}
+
+static int
+os_frame_skip(os_frame_t *f, os_rbuf_t *rb)
+{
+	uint32_t used = os_rbuf_used(rb);
+	uint32_t pos;
+
+	if (0U != f->skip)
+	{
+		/* Drop the payload of a rejected length-prefixed frame (possibly across calls) */
+		uint32_t n = (used < f->skip) ? used : f->skip;
+
+		os_rbuf_consume(rb, n);
+
+		f->skip -= n;
+	}
+	else if (f->skip_delim)
+	{
+		if (-1 == os_rbuf_find(rb, 0U, f->delim, f->delim_len, &pos))
+		{
+			/* Drop everything except a possibly incomplete delimiter */
+			if (used >= f->delim_len)
+				os_rbuf_consume(rb, used - (f->delim_len - 1U));
+		}
+		else
+		{
+			/* Drop the tail of the rejected frame including its delimiter */
+			os_rbuf_consume(rb, pos + f->delim_len);
+
+			f->skip_delim = false;
+		}
+	}
+
+	if (0U != f->skip || f->skip_delim)
+	{
+		/* Set os_errno to indicate no complete frame */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Largest payload that can be accepted: max_len, but never more than fits in the ring
+ * buffer next to 'framing' bytes. A larger frame could never complete and would stall
+ * the decoder with a full ring buffer.
+*/
+static uint32_t
+os_frame_limit(const os_frame_t *f, os_rbuf_t *rb, uint32_t framing)
+{
+	uint32_t cap   = os_rbuf_used(rb) + os_rbuf_free(rb);
+	uint32_t limit = (cap > framing) ? cap - framing : 0U;
+
+	if (0U != f->max_len && f->max_len < limit)
+		limit = f->max_len;
+
+	return limit;
+}
+
+static int
+os_frame_locate_len(os_frame_t *f, os_rbuf_t *rb, uint32_t *p_off, uint32_t *p_len)
+{
+	uint8_t  tmp[4U];
+	uint32_t used = os_rbuf_used(rb);
+	uint32_t len;
+
+	/* Wait for the complete length prefix */
+	if (used < f->len_width || -1 == os_rbuf_peek(rb, 0U, tmp, f->len_width))
+	{
+		/* Set os_errno to indicate no complete frame */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	if (1U == f->len_width)
+		len = tmp[0U];
+	else if (2U == f->len_width)
+		len = f->len_big_endian ? WORD_BE16(tmp) : WORD_LE16(tmp);
+	else
+		len = f->len_big_endian ? WORD_BE32(tmp) : WORD_LE32(tmp);
+
+	/* Length prefix counts its own bytes */
+	if (f->len_inclusive)
+	{
+		if (len < f->len_width)
+		{
+			/* Drop the malformed prefix when consumed */
+			f->frame_len = f->len_width;
+
+			/* Set os_errno to indicate an invalid frame */
+			os_errno = OS_EOVERFLOW;
+
+			return -1;
+		}
+
+		len -= f->len_width;
+	}
+
+	if (len > os_frame_limit(f, rb, f->len_width))
+	{
+		/* The payload may never fit in the ring; drop the prefix when consumed, then the payload */
+		f->frame_len  = f->len_width;
+		f->frame_skip = len;
+
+		/* Set os_errno to indicate the frame is too large */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	/* Wait for the complete payload */
+	if ((uint64_t) used < (uint64_t) f->len_width + len)
+	{
+		/* Set os_errno to indicate no complete frame */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	*p_off = f->len_width;
+	*p_len = len;
+
+	f->frame_len = f->len_width + len;
+
+	return 0;
+}
+
+static int
+os_frame_locate_delim(os_frame_t *f, os_rbuf_t *rb, uint32_t *p_off, uint32_t *p_len)
+{
+	uint32_t used;
+	uint32_t pos;
+
+	while (1)
+	{
+		used = os_rbuf_used(rb);
+
+		/* Only search the bytes not inspected by previous calls */
+		if (-1 == os_rbuf_find(rb, f->scanned, f->delim, f->delim_len, &pos))
+		{
+			/* Resume where a delimiter could still start on the next call */
+			if (used >= f->delim_len)
+				f->scanned = used - (f->delim_len - 1U);
+
+			if (f->scanned > os_frame_limit(f, rb, f->delim_len))
+			{
+				/* Drop everything scanned so far when consumed, then the rest up to the delimiter */
+				f->frame_len		= f->scanned;
+				f->frame_skip_delim = true;
+
+				/* Set os_errno to indicate the frame is too large */
+				os_errno = OS_EOVERFLOW;
+
+				return -1;
+			}
+
+			/* Set os_errno to indicate no complete frame */
+			os_errno = OS_EAGAIN;
+
+			return -1;
+		}
+
+		/* Skip empty SLIP/COBS frames (back-to-back terminators) */
+		if (0U == pos && OS_FRAME_DELIM != f->type)
+		{
+			os_rbuf_consume(rb, f->delim_len);
+
+			f->scanned = 0U;
+
+			continue;
+		}
+
+		break;
+	}
+
+	f->frame_len = pos + f->delim_len;
+
+	if (pos > os_frame_limit(f, rb, f->delim_len))
+	{
+		/* Set os_errno to indicate the frame is too large */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	*p_off = 0U;
+	*p_len = pos;
+
+	return 0;
+}
+
+static int
+os_frame_locate(os_frame_t *f, os_rbuf_t *rb, uint32_t *p_off, uint32_t *p_len)
+{
+	f->frame_len		= 0U;
+	f->frame_skip		= 0U;
+	f->frame_skip_delim = false;
+
+	/* Finish dropping a rejected frame before looking for the next one */
+	if (-1 == os_frame_skip(f, rb))
+		return -1;
+
+	if (OS_FRAME_LEN == f->type)
+		return os_frame_locate_len(f, rb, p_off, p_len);
+
+	return os_frame_locate_delim(f, rb, p_off, p_len);
+}
+
+static void
+os_frame_slice(os_rbuf_t *rb, uint32_t off, uint32_t len, os_rbuf_span_t spans[2])
+{
+	os_rbuf_span_t all[2];
+
+	os_rbuf_read_spans(rb, all);
+
+	spans[0] = (os_rbuf_span_t){ NULL, 0U };
+	spans[1] = (os_rbuf_span_t){ NULL, 0U };
+
+	if (0U == len)
+		return;
+
+	/* Region starts in the second span */
+	if (off >= all[0].len)
+	{
+		spans[0] = (os_rbuf_span_t){ &all[1].data[off - all[0].len], len };
+
+		return;
+	}
+
+	/* Region starts in the first span, possibly continuing in the second */
+	if (len <= all[0].len - off)
+	{
+		spans[0] = (os_rbuf_span_t){ &all[0].data[off], len };
+	}
+	else
+	{
+		spans[0] = (os_rbuf_span_t){ &all[0].data[off], all[0].len - off };
+		spans[1] = (os_rbuf_span_t){ all[1].data, len - (all[0].len - off) };
+	}
+}
+
+static inline uint8_t
+os_frame_byte(const os_rbuf_span_t spans[2], uint32_t i)
+{
+	return (i < spans[0].len) ? spans[0].data[i] : spans[1].data[i - spans[0].len];
+}
+
+static int
+os_frame_decode_slip(const os_rbuf_span_t spans[2], uint32_t len, uint8_t *p_buffer, uint32_t bufsize, uint32_t *p_len)
+{
+	uint32_t n = 0U;
+
+	for (uint32_t i = 0U; i < len; i++)
+	{
+		uint8_t c = os_frame_byte(spans, i);
+
+		/* Translate escape sequences */
+		if (SLIP_ESC == c)
+		{
+			if (++i >= len)
+				return OS_EINVAL;
+
+			c = os_frame_byte(spans, i);
+
+			if (SLIP_ESC_END == c)
+				c = SLIP_END;
+			else if (SLIP_ESC_ESC == c)
+				c = SLIP_ESC;
+			else
+				return OS_EINVAL;
+		}
+
+		if (n >= bufsize)
+			return OS_EOVERFLOW;
+
+		p_buffer[n++] = c;
+	}
+
+	*p_len = n;
+
+	return OS_EOK;
+}
+
+static int
+os_frame_decode_cobs(const os_rbuf_span_t spans[2], uint32_t len, uint8_t *p_buffer, uint32_t bufsize, uint32_t *p_len)
+{
+	uint32_t n = 0U;
+	uint32_t i = 0U;
+
+	while (i < len)
+	{
+		uint8_t code = os_frame_byte(spans, i++);
+
+		if (0U == code || i + (code - 1U) > len)
+			return OS_EINVAL;
+
+		if (n + (code - 1U) > bufsize)
+			return OS_EOVERFLOW;
+
+		/* Copy the run of non-zero bytes */
+		for (uint32_t j = 1U; j < code; j++)
+			p_buffer[n++] = os_frame_byte(spans, i++);
+
+		/* Every block except a full one (or the last) is followed by a zero */
+		if (0xFFU != code && i < len)
+		{
+			if (n >= bufsize)
+				return OS_EOVERFLOW;
+
+			p_buffer[n++] = 0U;
+		}
+	}
+
+	*p_len = n;
+
+	return OS_EOK;
+}
+
+int
+os_frame_peek(os_frame_t *f, os_rbuf_t *rb, os_rbuf_span_t spans[2], uint32_t *p_len)
+{
+	uint32_t off;
+	uint32_t len;
+
+	if (NULL == f || NULL == rb || NULL == spans)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_frame_locate(f, rb, &off, &len))
+		return -1;
+
+	/* Describe the frame in place */
+	os_frame_slice(rb, off, len, spans);
+
+	if (NULL != p_len)
+		*p_len = len;
+
+	return 0;
+}
+
+int
+os_frame_consume(os_frame_t *f, os_rbuf_t *rb)
+{
+	if (NULL == f || NULL == rb)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (0U == f->frame_len)
+	{
+		/* Set os_errno to indicate no frame was located */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Remove the frame and its framing */
+	if (-1 == os_rbuf_consume(rb, f->frame_len))
+		return -1;
+
+	/* Rest of a rejected frame is dropped by the next os_frame_locate() */
+	f->skip		  = f->frame_skip;
+	f->skip_delim = f->frame_skip_delim;
+
+	/* Next frame starts at the head of the ring buffer */
+	f->scanned			= 0U;
+	f->frame_len		= 0U;
+	f->frame_skip		= 0U;
+	f->frame_skip_delim = false;
+
+	return 0;
+}
+
+int
+os_frame_decode(os_frame_t *f, os_rbuf_t *rb, uint8_t *p_buffer, uint32_t bufsize, uint32_t *p_len)
+{
+	os_rbuf_span_t spans[2];
+	uint32_t off;
+	uint32_t len;
+	int err = OS_EOK;
+
+	if (NULL == f || NULL == rb || NULL == p_buffer || NULL == p_len)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (-1 == os_frame_locate(f, rb, &off, &len))
+	{
+		/* Drop oversized frames so the caller can continue with the next one */
+		if (OS_EOVERFLOW == os_errno)
+		{
+			os_frame_consume(f, rb);
+
+			/* Set os_errno to indicate the frame was too large */
+			os_errno = OS_EOVERFLOW;
+		}
+
+		return -1;
+	}
+
+	os_frame_slice(rb, off, len, spans);
+
+	if (OS_FRAME_SLIP == f->type)
+	{
+		err = os_frame_decode_slip(spans, len, p_buffer, bufsize, p_len);
+	}
+	else if (OS_FRAME_COBS == f->type)
+	{
+		err = os_frame_decode_cobs(spans, len, p_buffer, bufsize, p_len);
+	}
+	else if (len > bufsize)
+	{
+		err = OS_EOVERFLOW;
+	}
+	else
+	{
+		/* Payload is stored as-is; copy at most two segments (unused spans have no data) */
+		if (0U != spans[0].len)
+			memcpy(p_buffer, spans[0].data, spans[0].len);
+
+		if (0U != spans[1].len)
+			memcpy(p_buffer + spans[0].len, spans[1].data, spans[1].len);
+
+		*p_len = len;
+	}
+
+	/* The frame is removed whether or not it could be decoded */
+	os_frame_consume(f, rb);
+
+	if (OS_EOK != err)
+	{
+		/* Set os_errno to indicate why the frame was dropped */
+		os_errno = err;
+
+		return -1;
+	}
+
+	return 0;
+}
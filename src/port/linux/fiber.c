@@ -0,0 +1,468 @@
+#include "../../../inc/fiber.h"
+#include "../../../inc/errno.h"
+#include "../../../inc/task.h"
+
+#include "../../private.h"
+
+#include <sys/mman.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler running on the current thread */
+static __thread os_fiber_sched_t *t_fiber_sched;
+
+/* ------------------------------------------------------------ */
+
+static void os_fiber_main(os_fiber_t *f) __attribute__((noreturn, used));
+
+#if defined(__x86_64__)
+
+/*
+ * Save the callee-saved registers (and MXCSR/x87 control word) on the current stack,
+ * store the stack pointer to *p_save_sp, switch to 'sp' and restore from there.
+*/
+void os_fiber_swap(void **p_save_sp, void *sp);
+
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	".globl os_fiber_swap\n"
+	".hidden os_fiber_swap\n"
+	".type os_fiber_swap, @function\n"
+	"os_fiber_swap:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $8, %rsp\n"
+	"	stmxcsr (%rsp)\n"
+	"	fnstcw 4(%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	ldmxcsr (%rsp)\n"
+	"	fldcw 4(%rsp)\n"
+	"	addq $8, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".size os_fiber_swap, .-os_fiber_swap\n"
+
+	/* First switch to a fiber 'returns' here with the fiber in r12 */
+	".p2align 4\n"
+	".type os_fiber_boot, @function\n"
+	"os_fiber_boot:\n"
+	"	movq %r12, %rdi\n"
+	"	call os_fiber_main\n"
+	"	ud2\n"
+	".size os_fiber_boot, .-os_fiber_boot\n"
+);
+
+extern char os_fiber_boot[] __asm__("os_fiber_boot");
+
+static void
+os_fiber_prepare(os_fiber_t *f)
+{
+	/* Stack top is 16-byte aligned; os_fiber_boot is entered with an aligned stack */
+	uint64_t *top = (uint64_t *)(f->stack + f->stack_size);
+	uint64_t *sp  = top - 8;
+
+	/* Layout popped by os_fiber_swap: mxcsr/fpu cw, r15, r14, r13, r12, rbx, rbp, return */
+	memset(sp, 0, 8U * sizeof(*sp));
+
+	sp[0] = 0x037F00001F80ULL;	/* MXCSR = 0x1F80, x87 CW = 0x037F (defaults) */
+	sp[4] = (uint64_t)(uintptr_t) f;
+	sp[7] = (uint64_t)(uintptr_t) os_fiber_boot;
+
+	f->sp = sp;
+}
+
+#elif defined(__aarch64__)
+
+/*
+ * Save the callee-saved registers (x19-x30, d8-d15) on the current stack, store the
+ * stack pointer to *p_save_sp, switch to 'sp' and restore from there.
+*/
+void os_fiber_swap(void **p_save_sp, void *sp);
+
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	".globl os_fiber_swap\n"
+	".hidden os_fiber_swap\n"
+	".type os_fiber_swap, %function\n"
+	"os_fiber_swap:\n"
+	"	sub sp, sp, #160\n"
+	"	stp x19, x20, [sp, #0]\n"
+	"	stp x21, x22, [sp, #16]\n"
+	"	stp x23, x24, [sp, #32]\n"
+	"	stp x25, x26, [sp, #48]\n"
+	"	stp x27, x28, [sp, #64]\n"
+	"	stp x29, x30, [sp, #80]\n"
+	"	stp d8, d9, [sp, #96]\n"
+	"	stp d10, d11, [sp, #112]\n"
+	"	stp d12, d13, [sp, #128]\n"
+	"	stp d14, d15, [sp, #144]\n"
+	"	mov x2, sp\n"
+	"	str x2, [x0]\n"
+	"	mov sp, x1\n"
+	"	ldp x19, x20, [sp, #0]\n"
+	"	ldp x21, x22, [sp, #16]\n"
+	"	ldp x23, x24, [sp, #32]\n"
+	"	ldp x25, x26, [sp, #48]\n"
+	"	ldp x27, x28, [sp, #64]\n"
+	"	ldp x29, x30, [sp, #80]\n"
+	"	ldp d8, d9, [sp, #96]\n"
+	"	ldp d10, d11, [sp, #112]\n"
+	"	ldp d12, d13, [sp, #128]\n"
+	"	ldp d14, d15, [sp, #144]\n"
+	"	add sp, sp, #160\n"
+	"	ret\n"
+	".size os_fiber_swap, .-os_fiber_swap\n"
+
+	/* First switch to a fiber 'returns' here with the fiber in x19 */
+	".p2align 4\n"
+	".type os_fiber_boot, %function\n"
+	"os_fiber_boot:\n"
+	"	mov x0, x19\n"
+	"	bl os_fiber_main\n"
+	"	brk #0\n"
+	".size os_fiber_boot, .-os_fiber_boot\n"
+);
+
+extern char os_fiber_boot[] __asm__("os_fiber_boot");
+
+static void
+os_fiber_prepare(os_fiber_t *f)
+{
+	uint64_t *top = (uint64_t *)(f->stack + f->stack_size);
+	uint64_t *sp  = top - 20;
+
+	/* Layout popped by os_fiber_swap: x19..x28, x29, x30, d8..d15 */
+	memset(sp, 0, 20U * sizeof(*sp));
+
+	sp[0]  = (uint64_t)(uintptr_t) f;
+	sp[11] = (uint64_t)(uintptr_t) os_fiber_boot;
+
+	f->sp = sp;
+}
+
+#else
+
+static void
+os_fiber_entry()
+{
+	os_fiber_main(t_fiber_sched->current);
+}
+
+static void
+os_fiber_prepare(os_fiber_t *f)
+{
+	getcontext(&f->ctx);
+
+	f->ctx.uc_stack.ss_sp	= f->stack + sysconf(_SC_PAGESIZE);
+	f->ctx.uc_stack.ss_size = f->stack_size - (size_t) sysconf(_SC_PAGESIZE);
+	f->ctx.uc_link			= NULL;
+
+	makecontext(&f->ctx, os_fiber_entry, 0);
+}
+
+#endif
+
+static inline void
+os_fiber_to_sched(os_fiber_t *f)
+{
+#ifdef OS_FIBER_UCONTEXT
+	swapcontext(&f->ctx, &f->sched->ctx);
+#else
+	os_fiber_swap(&f->sp, f->sched->sp);
+#endif
+}
+
+static inline void
+os_fiber_from_sched(os_fiber_sched_t *s, os_fiber_t *f)
+{
+#ifdef OS_FIBER_UCONTEXT
+	swapcontext(&s->ctx, &f->ctx);
+#else
+	os_fiber_swap(&s->sp, f->sp);
+#endif
+}
+
+static void
+os_fiber_main(os_fiber_t *f)
+{
+	f->p_func(f->p_func_arg);
+
+	f->state = OS_FIBER_DONE;
+
+	/* Never resumed; the scheduler only runs ready fibers */
+	os_fiber_to_sched(f);
+
+	abort();
+}
+
+static void
+os_fiber_enqueue(os_fiber_sched_t *s, os_fiber_t *f)
+{
+	f->state = OS_FIBER_READY;
+	f->next	 = NULL;
+
+	if (NULL == s->tail)
+		s->head = f;
+	else
+		s->tail->next = f;
+
+	s->tail = f;
+}
+
+static void
+os_fiber_unlink(os_fiber_sched_t *s, os_fiber_t *f)
+{
+	os_fiber_t *prev = NULL;
+
+	for (os_fiber_t *it = s->head; NULL != it; prev = it, it = it->next)
+	{
+		if (f != it)
+			continue;
+
+		if (NULL == prev)
+			s->head = f->next;
+		else
+			prev->next = f->next;
+
+		if (s->tail == f)
+			s->tail = prev;
+
+		break;
+	}
+
+	f->next = NULL;
+}
+
+int
+os_fiber_sched_init(os_fiber_sched_t *s)
+{
+	if (NULL == s)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out scheduler memory */
+	memset(s, 0, sizeof(*s));
+
+	return 0;
+}
+
+int
+os_fiber_sched_run(os_fiber_sched_t *s, os_task_t *host)
+{
+	os_fiber_sched_t *prev;
+
+	if (NULL == s || NULL != s->current)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	prev		  = t_fiber_sched;
+	t_fiber_sched = s;
+
+	while (NULL != s->head && !os_task_check_stop(host))
+	{
+		os_fiber_t *f = s->head;
+
+		/* Dequeue the next ready fiber */
+		s->head = f->next;
+		if (NULL == s->head)
+			s->tail = NULL;
+
+		f->state   = OS_FIBER_RUNNING;
+		s->current = f;
+
+		os_fiber_from_sched(s, f);
+
+		s->current = NULL;
+
+		/* A fiber that is still marked running has yielded */
+		if (OS_FIBER_RUNNING == f->state)
+			os_fiber_enqueue(s, f);
+		else if (OS_FIBER_DONE == f->state)
+			s->count--;
+	}
+
+	t_fiber_sched = prev;
+
+	return 0;
+}
+
+int
+os_fiber_init(os_fiber_t *f, os_fiber_sched_t *s, os_fiber_func_f p_func, void *p_func_arg, size_t stack_size)
+{
+	size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+	if (NULL == f || NULL == s || NULL == p_func)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (0U == stack_size)
+		stack_size = OS_FIBER_STACK_SIZE;
+
+	/* Clear out new fiber memory */
+	memset(f, 0, sizeof(*f));
+
+	/* Usable stack rounded up to pages, plus one guard page below it */
+	f->stack_size = ((stack_size + page - 1U) & ~(page - 1U)) + page;
+
+	f->stack = mmap(NULL, f->stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	if (MAP_FAILED == f->stack)
+	{
+		f->stack = NULL;
+
+		/* Set os_errno to indicate the stack could not be allocated */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	/* Stack overflows fault instead of silently corrupting memory */
+	if (-1 == mprotect(f->stack, page, PROT_NONE))
+	{
+		munmap(f->stack, f->stack_size);
+
+		/* Set os_errno to indicate the guard page could not be set up */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	f->p_func	  = p_func;
+	f->p_func_arg = p_func_arg;
+	f->sched	  = s;
+
+	os_fiber_prepare(f);
+
+	s->count++;
+
+	os_fiber_enqueue(s, f);
+
+	return 0;
+}
+
+int
+os_fiber_destroy(os_fiber_t *f)
+{
+	if (NULL == f || NULL == f->stack)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (OS_FIBER_RUNNING == f->state || f == f->sched->current)
+	{
+		/* Set os_errno to indicate the fiber is still in use */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	if (OS_FIBER_READY == f->state)
+		os_fiber_unlink(f->sched, f);
+
+	/* Finished fibers were already removed from the count by the scheduler */
+	if (OS_FIBER_DONE != f->state)
+		f->sched->count--;
+
+	munmap(f->stack, f->stack_size);
+
+	/* Clear memory */
+	memset(f, 0, sizeof(*f));
+
+	return 0;
+}
+
+int
+os_fiber_yield()
+{
+	os_fiber_t *f = os_fiber_current();
+
+	if (NULL == f)
+	{
+		/* Set os_errno to indicate not called from a fiber */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* State stays OS_FIBER_RUNNING; the scheduler queues the fiber again */
+	os_fiber_to_sched(f);
+
+	return 0;
+}
+
+int
+os_fiber_suspend()
+{
+	os_fiber_t *f = os_fiber_current();
+
+	if (NULL == f)
+	{
+		/* Set os_errno to indicate not called from a fiber */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	f->state = OS_FIBER_SUSPENDED;
+
+	os_fiber_to_sched(f);
+
+	return 0;
+}
+
+int
+os_fiber_resume(os_fiber_t *f)
+{
+	if (NULL == f || NULL == f->sched)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Only suspended fibers are queued again; resuming a ready fiber is a no-op */
+	if (OS_FIBER_SUSPENDED == f->state)
+		os_fiber_enqueue(f->sched, f);
+
+	return 0;
+}
+
+os_fiber_t *
+os_fiber_current()
+{
+	if (NULL == t_fiber_sched)
+		return NULL;
+
+	return t_fiber_sched->current;
+}
@@ -0,0 +1,529 @@
+#include "../../../inc/pool.h"
+#include "../../../inc/assert.h"
+#include "../../../inc/errno.h"
+#include "../../../inc/mutex.h"
+#include "../../../inc/runtime.h"
+#include "../../../inc/task.h"
+
+#include "../../private.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* Idle workers re-check os_runtime_exiting() at least this often (the runtime does not wake them) */
+#define POOL_IDLE_MS 100U
+
+/* Joiners blocked in os_pool_group_wait() re-check for queued jobs at least this often */
+#define POOL_JOIN_MS 1U
+
+/* Worker running on the current thread (NULL for non-worker threads) */
+static __thread os_pool_worker_t *t_pool_worker;
+
+/* ------------------------------------------------------------ */
+
+static bool
+os_pool_pop(os_pool_worker_t *w, os_pool_job_t *p_job, bool steal)
+{
+	bool found = false;
+
+	os_assert(0 == os_mutex_lock(&w->mutex));
+
+	if (w->head != w->tail)
+	{
+		/* Owner takes the newest job, thieves take the oldest */
+		if (steal)
+			*p_job = w->jobs[w->head++ & (w->size - 1U)];
+		else
+			*p_job = w->jobs[--w->tail & (w->size - 1U)];
+
+		found = true;
+	}
+
+	os_assert(0 == os_mutex_unlock(&w->mutex));
+
+	return found;
+}
+
+static bool
+os_pool_push(os_pool_worker_t *w, const os_pool_job_t *job)
+{
+	bool queued = false;
+
+	os_assert(0 == os_mutex_lock(&w->mutex));
+
+	if (w->tail - w->head < w->size)
+	{
+		w->jobs[w->tail++ & (w->size - 1U)] = *job;
+
+		queued = true;
+	}
+
+	os_assert(0 == os_mutex_unlock(&w->mutex));
+
+	return queued;
+}
+
+static bool
+os_pool_take(os_pool_t *p, os_pool_worker_t *self, os_pool_job_t *p_job)
+{
+	uint32_t start = 0U;
+
+	/* Nothing queued anywhere; don't touch the deques */
+	if (0U == __atomic_load_n(&p->pending, __ATOMIC_ACQUIRE))
+		return false;
+
+	if (NULL != self)
+	{
+		if (os_pool_pop(self, p_job, false))
+			goto taken;
+
+		start = (uint32_t)(self - p->workers) + 1U;
+	}
+
+	/* Steal from the other workers, starting with the next one */
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		os_pool_worker_t *victim = &p->workers[(start + i) % p->count];
+
+		if (victim != self && os_pool_pop(victim, p_job, true))
+			goto taken;
+	}
+
+	return false;
+
+taken:
+	__atomic_fetch_sub(&p->pending, 1U, __ATOMIC_ACQ_REL);
+
+	return true;
+}
+
+static void
+os_pool_idle(os_pool_t *p)
+{
+	os_time_t deadline = os_time_add_ms(os_time_monotonic(), POOL_IDLE_MS);
+
+	/* Announce the sleeper before re-checking, so a concurrent submit wakes it */
+	__atomic_fetch_add(&p->sleepers, 1U, __ATOMIC_SEQ_CST);
+
+	/*
+	 * Sleep while nothing is pending; a submit changes the word (no lost wake-up) and
+	 * os_task_stop() on the worker or os_pool_destroy() ends the sleep as well.
+	*/
+	if (0U == __atomic_load_n(&p->stopping, __ATOMIC_ACQUIRE))
+		os_prv_task_futex_wait(&p->pending, 0U, &deadline);
+
+	__atomic_fetch_sub(&p->sleepers, 1U, __ATOMIC_SEQ_CST);
+}
+
+static void
+os_pool_wake(os_pool_t *p)
+{
+	/* Only pay for the system call when a worker is sleeping */
+	if (0U == __atomic_load_n(&p->sleepers, __ATOMIC_SEQ_CST))
+		return;
+
+	syscall(SYS_futex, &p->pending, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+static void
+os_pool_run(const os_pool_job_t *job)
+{
+	job->p_func(job->p_func_arg);
+
+	/*
+	 * Release pairs with os_pool_group_wait(); the job's writes are visible to the joiner.
+	 * The joiner may return (and the group go away) once pending is 0, so the last job
+	 * only passes the address to the kernel to wake it.
+	*/
+	if (NULL != job->group && 1U == __atomic_fetch_sub(&job->group->pending, 1U, __ATOMIC_RELEASE))
+		syscall(SYS_futex, &job->group->pending, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static bool
+os_pool_enqueue(os_pool_t *p, const os_pool_job_t *job)
+{
+	os_pool_worker_t *self = t_pool_worker;
+	uint32_t start;
+
+	/* Workers queue on their own deque; other threads spread the jobs round-robin */
+	if (NULL != self && self->pool == p)
+		start = (uint32_t)(self - p->workers);
+	else
+		start = __atomic_fetch_add(&p->next, 1U, __ATOMIC_RELAXED);
+
+	/* Count the job before it becomes visible, so takers never see pending underflow */
+	__atomic_fetch_add(&p->pending, 1U, __ATOMIC_SEQ_CST);
+
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		if (os_pool_push(&p->workers[(start + i) % p->count], job))
+		{
+			os_pool_wake(p);
+
+			return true;
+		}
+	}
+
+	__atomic_fetch_sub(&p->pending, 1U, __ATOMIC_SEQ_CST);
+
+	return false;
+}
+
+static void *
+os_pool_worker(void *param)
+{
+	os_pool_worker_t *w = param;
+	os_pool_job_t job;
+
+	t_pool_worker = w;
+
+	while (0U == __atomic_load_n(&w->pool->stopping, __ATOMIC_ACQUIRE) && !os_task_check_stop(&w->task))
+	{
+		if (os_pool_take(w->pool, w, &job))
+		{
+			os_pool_run(&job);
+
+			continue;
+		}
+
+		/* Runtime exit takes the runtime mutex; only check it when out of work */
+		if (os_runtime_exiting())
+			break;
+
+		os_pool_idle(w->pool);
+	}
+
+	t_pool_worker = NULL;
+
+	return NULL;
+}
+
+int
+os_pool_init(os_pool_t *p, uint32_t count, uint32_t queue_size)
+{
+	uint32_t size = 1U;
+
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (0U == count)
+	{
+		long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+		count = (ncpu > 0) ? (uint32_t) ncpu : 1U;
+	}
+
+	if (0U == queue_size)
+		queue_size = OS_POOL_QUEUE_SIZE;
+
+	/* Job deque size must be power of 2 for cursor calculation logic */
+	while (size < queue_size)
+	{
+		if (size > (UINT32_MAX >> 1U))
+		{
+			/* Set os_errno to indicate invalid arguments */
+			os_errno = OS_EINVAL;
+
+			return -1;
+		}
+
+		size <<= 1U;
+	}
+
+	/* Clear out new pool memory */
+	memset(p, 0, sizeof(*p));
+
+	p->workers = calloc(count, sizeof(*p->workers));
+	if (NULL == p->workers)
+	{
+		/* Set os_errno to indicate memory allocation failure */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	/* Set up every job deque before any worker can steal from it */
+	for (uint32_t i = 0U; i < count; i++)
+	{
+		os_pool_worker_t *w = &p->workers[i];
+
+		w->pool = p;
+		w->size = size;
+		w->jobs = calloc(size, sizeof(*w->jobs));
+
+		if (NULL == w->jobs || -1 == os_mutex_init(&w->mutex))
+		{
+			p->count = i + 1U;
+
+			os_pool_destroy(p);
+
+			/* Set os_errno to indicate memory allocation failure */
+			os_errno = OS_ENOMEM;
+
+			return -1;
+		}
+	}
+
+	p->count = count;
+
+	for (uint32_t i = 0U; i < count; i++)
+	{
+		char name[OS_TASK_NAME_SIZE + 1U];
+
+		snprintf(name, sizeof(name), "pool-%u", i);
+
+		if (-1 == os_task_init(&p->workers[i].task, name, os_pool_worker, &p->workers[i]))
+		{
+			OS_PRV_ERR("os_pool_init(): os_task_init() failed for worker %u", i);
+
+			/* Only the workers that were started are joined */
+			memset(&p->workers[i].task, 0, sizeof(p->workers[i].task));
+
+			os_pool_destroy(p);
+
+			/* Set os_errno to indicate the workers could not be started */
+			os_errno = OS_EERROR;
+
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int
+os_pool_destroy(os_pool_t *p)
+{
+	if (NULL == p || NULL == p->workers)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Stop all workers in parallel and wake the sleeping ones so they notice */
+	__atomic_store_n(&p->stopping, 1U, __ATOMIC_SEQ_CST);
+	syscall(SYS_futex, &p->pending, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		os_pool_worker_t *w = &p->workers[i];
+
+		if (0U != w->task.thread)
+			os_task_destroy(&w->task);
+
+		os_mutex_destroy(&w->mutex);
+
+		free(w->jobs);
+	}
+
+	free(p->workers);
+
+	/* Clear memory */
+	memset(p, 0, sizeof(*p));
+
+	return 0;
+}
+
+int
+os_pool_submit(os_pool_t *p, os_pool_job_f p_func, void *p_func_arg)
+{
+	os_pool_job_t job = { p_func, p_func_arg, NULL };
+
+	if (NULL == p || NULL == p->workers || NULL == p_func)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (!os_pool_enqueue(p, &job))
+	{
+		/* Set os_errno to indicate every job queue is full */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	return 0;
+}
+
+uint32_t
+os_pool_pending(os_pool_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	return __atomic_load_n(&p->pending, __ATOMIC_ACQUIRE);
+}
+
+int
+os_pool_group_init(os_pool_group_t *g, os_pool_t *p)
+{
+	if (NULL == g || NULL == p || NULL == p->workers)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	g->pool	   = p;
+	g->pending = 0U;
+
+	return 0;
+}
+
+int
+os_pool_group_submit(os_pool_group_t *g, os_pool_job_f p_func, void *p_func_arg)
+{
+	os_pool_job_t job = { p_func, p_func_arg, g };
+
+	if (NULL == g || NULL == g->pool || NULL == p_func)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	__atomic_fetch_add(&g->pending, 1U, __ATOMIC_RELAXED);
+
+	/* No queue space; run the job now rather than failing the fork */
+	if (!os_pool_enqueue(g->pool, &job))
+		os_pool_run(&job);
+
+	return 0;
+}
+
+int
+os_pool_group_wait(os_pool_group_t *g)
+{
+	os_pool_worker_t *self = t_pool_worker;
+	struct timespec timeout = { 0, (long)(POOL_JOIN_MS * 1000000U) };
+	os_pool_job_t job;
+	uint32_t pending;
+
+	if (NULL == g || NULL == g->pool)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (NULL != self && self->pool != g->pool)
+		self = NULL;
+
+	/* Help with queued jobs (of any group) instead of blocking a worker */
+	while (0U != (pending = __atomic_load_n(&g->pending, __ATOMIC_ACQUIRE)))
+	{
+		if (os_pool_take(g->pool, self, &job))
+		{
+			os_pool_run(&job);
+
+			continue;
+		}
+
+		/* Only running jobs are left; sleep until the last one finishes (or new jobs may be queued) */
+		syscall(SYS_futex, &g->pending, FUTEX_WAIT_PRIVATE, pending, &timeout, NULL, 0);
+	}
+
+	return 0;
+}
+
+/* Shared state of an os_pool_parallel_for() call */
+typedef struct
+{
+	size_t next;
+	size_t end;
+	size_t grain;
+
+	os_pool_range_f p_func;
+	void *ctx;
+} os_pool_for_t;
+
+static void
+os_pool_for_run(void *arg)
+{
+	os_pool_for_t *f = arg;
+	size_t begin;
+
+	/* Claim chunks until the range is exhausted */
+	while ((begin = __atomic_fetch_add(&f->next, f->grain, __ATOMIC_RELAXED)) < f->end)
+	{
+		size_t end = (f->end - begin > f->grain) ? begin + f->grain : f->end;
+
+		f->p_func(f->ctx, begin, end);
+	}
+}
+
+int
+os_pool_parallel_for(os_pool_t *p, size_t begin, size_t end, size_t grain, os_pool_range_f p_func, void *ctx)
+{
+	os_pool_group_t group;
+	os_pool_for_t f;
+	size_t chunks;
+	uint32_t helpers;
+
+	if (NULL == p || NULL == p->workers || NULL == p_func || end < begin)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (begin == end)
+		return 0;
+
+	if (0U == grain)
+	{
+		grain = (end - begin) / ((size_t) p->count * 8U);
+
+		if (0U == grain)
+			grain = 1U;
+	}
+
+	/* One helper job per worker that can get a chunk; the caller takes part as well */
+	chunks	= ((end - begin) / grain) + ((0U != (end - begin) % grain) ? 1U : 0U);
+	helpers = (chunks - 1U < p->count) ? (uint32_t)(chunks - 1U) : p->count;
+
+	/*
+	 * Chunk claiming must not overflow the index type: after the last chunk starting below
+	 * 'end' has been claimed, each of the helpers + 1 participants overshoots once more.
+	*/
+	if (grain > (SIZE_MAX - end) / ((size_t) helpers + 2U))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	f = (os_pool_for_t){ begin, end, grain, p_func, ctx };
+
+	os_pool_group_init(&group, p);
+
+	for (uint32_t i = 0U; i < helpers; i++)
+		os_pool_group_submit(&group, os_pool_for_run, &f);
+
+	os_pool_for_run(&f);
+
+	return os_pool_group_wait(&group);
+}
@@ -0,0 +1,382 @@
+#include "../../private.h"
+
+#include "../../../inc/assert.h"
+#include "../../../inc/errno.h"
+#include "../../../inc/mutex.h"
+#include "../../../inc/qrec.h"
+#include "../../../inc/runtime.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Records are padded so every header is 8-byte aligned */
+#define QREC_ALIGN(n) (((n) + 7U) & ~((uint64_t) 7U))
+
+/* Defined in queue.c */
+extern os_mutex_t g_queue_mutex;
+
+/* Recorder attached to the queue layer (read by queue.c while holding g_queue_mutex) */
+os_qrec_t *g_queue_recorder;
+
+/* ------------------------------------------------------------ */
+
+int
+os_qrec_open(os_qrec_t *p, const char *path, uint64_t capacity)
+{
+	os_qrec_header_t *hdr;
+
+	if (NULL == p || NULL == path || capacity < sizeof(os_qrec_header_t))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out new recorder memory */
+	memset(p, 0, sizeof(*p));
+
+	p->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (-1 == p->fd)
+	{
+		OS_PRV_ERR("os_qrec_open(): open() failed: %d", errno);
+
+		/* Set os_errno to indicate the file could not be created */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Size the (sparse) file up-front so appending never needs a syscall */
+	if (-1 == ftruncate(p->fd, (off_t) capacity))
+	{
+		OS_PRV_ERR("os_qrec_open(): ftruncate() failed: %d", errno);
+
+		close(p->fd);
+		unlink(path);
+
+		/* Set os_errno to indicate the file could not be sized */
+		os_errno = OS_EERROR;
+
+		return -1;
+	}
+
+	p->map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+	if (MAP_FAILED == p->map)
+	{
+		close(p->fd);
+		unlink(path);
+
+		/* Set os_errno to indicate the file could not be mapped */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	p->capacity = capacity;
+	p->offset	= sizeof(os_qrec_header_t);
+
+	/* Write the recording file header */
+	hdr = (os_qrec_header_t *) p->map;
+	hdr->magic	  = OS_QREC_MAGIC;
+	hdr->version  = OS_QREC_VERSION;
+	hdr->start_ns = os_prv_now_ns();
+
+	return 0;
+}
+
+int
+os_qrec_close(os_qrec_t *p)
+{
+	uint64_t used;
+
+	if (NULL == p || NULL == p->map)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Make sure no sender is still appending to this recorder */
+	os_qrec_stop(p);
+
+	/* Refuse new manual appends and wait for the ones in progress (pairs with os_qrec_append()) */
+	__atomic_store_n(&p->closing, 1U, __ATOMIC_SEQ_CST);
+
+	while (0U != __atomic_load_n(&p->writers, __ATOMIC_SEQ_CST))
+		sched_yield();
+
+	/* Only keep the bytes that were actually recorded */
+	used = __atomic_load_n(&p->offset, __ATOMIC_ACQUIRE);
+	if (used > p->capacity)
+		used = p->capacity;
+
+	munmap(p->map, p->capacity);
+
+	if (-1 == ftruncate(p->fd, (off_t) used))
+	{
+		OS_PRV_WRN("os_qrec_close(): ftruncate() failed: %d", errno);
+	}
+
+	close(p->fd);
+
+	/* Clear memory */
+	memset(p, 0, sizeof(*p));
+
+	return 0;
+}
+
+int
+os_qrec_start(os_qrec_t *p)
+{
+	int err = 0;
+
+	if (NULL == p || NULL == p->map)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Lock the global queue list mutex; senders only append while holding it */
+	os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+	if (NULL != g_queue_recorder && p != g_queue_recorder)
+	{
+		/* Set os_errno to indicate another recorder is attached */
+		os_errno = OS_EAGAIN;
+
+		err = -1;
+	}
+	else
+	{
+		__atomic_store_n(&g_queue_recorder, p, __ATOMIC_RELEASE);
+	}
+
+	/* Unlock the global queue list mutex */
+	os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+	return err;
+}
+
+int
+os_qrec_stop(os_qrec_t *p)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Lock the global queue list mutex; waits for in-flight appends to finish */
+	os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+	if (p == g_queue_recorder)
+		__atomic_store_n(&g_queue_recorder, NULL, __ATOMIC_RELEASE);
+
+	/* Unlock the global queue list mutex */
+	os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+	return 0;
+}
+
+int
+os_qrec_append(os_qrec_t *p, uint16_t type, const os_msg_t *msg, uint32_t nbytes)
+{
+	os_qrec_entry_t *entry;
+	uint64_t size;
+	uint64_t off;
+
+	if (NULL == p || NULL == p->map || NULL == msg || nbytes > sizeof(msg->data))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Announce the append before checking for close; os_qrec_close() waits for it to finish */
+	__atomic_fetch_add(&p->writers, 1U, __ATOMIC_SEQ_CST);
+
+	if (0U != __atomic_load_n(&p->closing, __ATOMIC_SEQ_CST))
+	{
+		__atomic_fetch_sub(&p->writers, 1U, __ATOMIC_RELEASE);
+
+		/* Set os_errno to indicate the recorder is being closed */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	size = QREC_ALIGN(sizeof(os_qrec_entry_t) + nbytes);
+
+	/* Reserve space for the record */
+	off = __atomic_fetch_add(&p->offset, size, __ATOMIC_RELAXED);
+	if (off + size > p->capacity)
+	{
+		__atomic_fetch_add(&p->dropped, 1U, __ATOMIC_RELAXED);
+		__atomic_fetch_sub(&p->writers, 1U, __ATOMIC_RELEASE);
+
+		/* Set os_errno to indicate the recording is full */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	entry = (os_qrec_entry_t *)(p->map + off);
+
+	/* Fill in the record (size is published last so readers never see partial records) */
+	entry->type		 = type;
+	entry->nbytes	 = (uint16_t) nbytes;
+	entry->timestamp = (0U != msg->timestamp) ? msg->timestamp : os_prv_now_ns();
+	entry->source	 = (uint64_t)(uintptr_t) msg->source;
+	entry->target	 = (uint64_t)(uintptr_t) msg->target;
+	entry->userdata	 = msg->userdata;
+	entry->id		 = msg->id;
+
+	memcpy(entry + 1, msg->data, nbytes);
+
+	__atomic_store_n(&entry->size, (uint32_t) size, __ATOMIC_RELEASE);
+
+	/* Done with the mapping */
+	__atomic_fetch_sub(&p->writers, 1U, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int
+os_qrec_replay(const char *path, double speed, os_qrec_map_f p_map, void *p_map_arg)
+{
+	const os_qrec_header_t *hdr;
+	struct timespec wake;
+	struct stat st;
+	uint8_t *map;
+	uint64_t off;
+	uint64_t first_ns = 0U;
+	uint64_t start_ns;
+	int fd;
+
+	if (NULL == path || speed < 0.0)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (-1 == fd)
+	{
+		/* Set os_errno to indicate the file could not be opened */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	if (-1 == fstat(fd, &st) || (uint64_t) st.st_size < sizeof(os_qrec_header_t))
+	{
+		close(fd);
+
+		/* Set os_errno to indicate the file is not a recording */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	/* The mapping keeps the file referenced */
+	close(fd);
+
+	if (MAP_FAILED == map)
+	{
+		/* Set os_errno to indicate the file could not be mapped */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	hdr = (const os_qrec_header_t *) map;
+	if (OS_QREC_MAGIC != hdr->magic || OS_QREC_VERSION != hdr->version)
+	{
+		munmap(map, (size_t) st.st_size);
+
+		/* Set os_errno to indicate the file is not a recording */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	start_ns = os_prv_now_ns();
+
+	/* Walk the records until the end marker (or end of file) */
+	for (off = sizeof(os_qrec_header_t); off + sizeof(os_qrec_entry_t) <= (uint64_t) st.st_size; )
+	{
+		const os_qrec_entry_t *entry = (const os_qrec_entry_t *)(map + off);
+		uint32_t size = __atomic_load_n(&entry->size, __ATOMIC_ACQUIRE);
+		os_msg_t msg;
+
+		if (0U == size || off + size > (uint64_t) st.st_size || entry->nbytes > sizeof(msg.data))
+			break;
+
+		if (os_runtime_exiting())
+			break;
+
+		if (0U == first_ns)
+			first_ns = entry->timestamp;
+
+		/* Wait until the (scaled) original send time */
+		if (speed > 0.0)
+		{
+			uint64_t due = start_ns + (uint64_t)((double)(entry->timestamp - first_ns) / speed);
+
+			wake.tv_sec	 = (time_t)(due / 1000000000U);
+			wake.tv_nsec = (long)(due % 1000000000U);
+
+			while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL))
+				;
+		}
+
+		/* Rebuild the message */
+		memset(&msg, 0, sizeof(msg));
+
+		msg.source	 = (NULL != p_map) ? p_map(entry->source, p_map_arg) : (os_queue_t *)(uintptr_t) entry->source;
+		msg.userdata = entry->userdata;
+		msg.id		 = entry->id;
+
+		memcpy(msg.data, entry + 1, entry->nbytes);
+
+		if (NULL != msg.source)
+		{
+			if (OS_QREC_TYPE_POST == entry->type)
+			{
+				os_queue_post(msg.source, &msg);
+			}
+			else
+			{
+				msg.target = (NULL != p_map) ? p_map(entry->target, p_map_arg) : (os_queue_t *)(uintptr_t) entry->target;
+
+				if (NULL != msg.target)
+					os_queue_send(msg.source, &msg);
+			}
+		}
+
+		off += size;
+	}
+
+	munmap(map, (size_t) st.st_size);
+
+	return 0;
+}
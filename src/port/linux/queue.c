@@ -1,26 +1,106 @@
 #include "../../private.h"
 
 #include "../../../inc/assert.h"
+#include "../../../inc/bytes.h"
 #include "../../../inc/errno.h"
 #include "../../../inc/mutex.h"
 #include "../../../inc/queue.h"
+#include "../../../inc/qrec.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 
 #if 0 != (OS_QUEUE_MSGID_MAX & (OS_QUEUE_MSGID_MAX - 1U))
 #error "OS_QUEUE_MSGID_MAX is not power of 2"
 #endif
 
+/* Producer and consumer cursors must not share a cache line with each other or the read-mostly fields */
+_Static_assert(offsetof(os_queue_t, tail) - offsetof(os_queue_t, name) - sizeof(((os_queue_t *) 0)->name) >= CACHE_LINE_SIZE,
+			   "os_queue_t tail shares a cache line with the read-mostly fields");
+_Static_assert(offsetof(os_queue_t, head) - offsetof(os_queue_t, tail) - sizeof(uint32_t) >= CACHE_LINE_SIZE,
+			   "os_queue_t head/tail share a cache line");
+_Static_assert(sizeof(os_queue_t) - offsetof(os_queue_t, head) >= CACHE_LINE_SIZE,
+			   "os_queue_t head shares a cache line with the memory after the queue");
+
 /* Initialized in runtime.c */
 os_mutex_t g_queue_mutex;
 
 static os_queue_t *g_queue_list;
 
+/* Passed to os_queue_record() when the used payload size is unknown */
+#define QUEUE_USED_UNKNOWN UINT32_MAX
+
+/* Number of queues os_queue_snapshot() copies per hold of the global queue lock */
+#define QUEUE_SNAPSHOT_BATCH 16U
+
+/* Defined in qrec.c */
+extern os_qrec_t *g_queue_recorder;
+
+/* Number of queues subscribed to each message ID; lets posts skip the list walk */
+static uint16_t g_queue_sub_count[OS_QUEUE_MSGID_MAX];
+
 /* ------------------------------------------------------------ */
 
+static uint32_t
+os_queue_msg_used(const os_msg_t *msg)
+{
+	uint32_t count = OS_QUEUE_PARAM_COUNT;
+
+	/* Trailing zero params are not part of the used payload */
+	while (0U != count && 0U == msg->params[count - 1U])
+		count--;
+
+	return count * sizeof(uint32_t);
+}
+
+static void
+os_queue_record(uint16_t type, const os_msg_t *msg, uint32_t nbytes)
+{
+	os_qrec_t *rec = __atomic_load_n(&g_queue_recorder, __ATOMIC_ACQUIRE);
+
+	/* Recording is disabled; this is the only cost on the hot path */
+	if (NULL == rec)
+		return;
+
+	if (QUEUE_USED_UNKNOWN == nbytes)
+		nbytes = os_queue_msg_used(msg);
+
+	os_qrec_append(rec, type, msg, nbytes);
+}
+
+static os_msg_t *
+os_queue_write(os_queue_t *q, os_queue_t *src, os_queue_t *dst, uint32_t userdata, uint32_t id,
+	uint32_t param_count, const uint32_t *params, bool zero, uint64_t timestamp)
+{
+	os_msg_t *slot = &q->buffer[q->tail];
+
+	/* Write the header and only the used params directly into the queue slot */
+	slot->source   = src;
+	slot->target   = dst;
+	slot->userdata = userdata;
+	slot->id	   = id;
+
+	/* Stamp the slot so the queue's oldest message age can be reported */
+	slot->timestamp = timestamp;
+
+	if (0U != param_count)
+		memcpy(slot->params, params, param_count * sizeof(uint32_t));
+
+	/* Legacy varargs callers may read params they did not pass; keep those zero */
+	if (zero && param_count < OS_QUEUE_PARAM_COUNT)
+		memset(&slot->params[param_count], 0, (OS_QUEUE_PARAM_COUNT - param_count) * sizeof(uint32_t));
+
+	/* Update the target queue's write index */
+	q->tail = (q->tail + 1U) & q->size;
+
+	return slot;
+}
+
 int
 os_queue_init(os_queue_t *p, os_msg_t *p_msg_pool, uint32_t pool_size)
 {
@@ -46,6 +126,16 @@ os_queue_init(os_queue_t *p, os_msg_t *p_msg_pool, uint32_t pool_size)
 	/* Clear queue memory */
 	memset(p, 0, sizeof(os_queue_t));
 
+	/* Allocate the (cold) subscription table outside of the queue control block */
+	p->subscriptions = calloc(OS_QUEUE_SUB_TABLE_SIZE, sizeof(uint32_t));
+	if (NULL == p->subscriptions)
+	{
+		/* Set os_errno to indicate the table could not be allocated */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
 	/* Initialize the queue's message pool */
 	p->buffer = p_msg_pool;
 	p->size	  = pool_size - 1U;
@@ -98,6 +188,23 @@ os_queue_destroy(os_queue_t *p)
 			if (NULL != prv)
 				prv->next = tmp->next;
 
+			/* Drop this queue's subscriptions from the global subscriber counts */
+			for (uint32_t off = 0U; off < OS_QUEUE_SUB_TABLE_SIZE; off++)
+			{
+				uint32_t bits = p->subscriptions[off];
+
+				while (0U != bits)
+				{
+					uint32_t bit = (uint32_t)(BIT_LOWEST(bits) - 1);
+
+					g_queue_sub_count[(off * 32U) + bit]--;
+
+					bits &= ~(1U << bit);
+				}
+			}
+
+			free(p->subscriptions);
+
 			/* Clear memory */
 			memset(p, 0, sizeof(*p));
 
@@ -118,11 +225,109 @@ os_queue_destroy(os_queue_t *p)
 	return 0;
 }
 
+int
+os_queue_set_name(os_queue_t *p, const char *name)
+{
+	if (NULL == p || NULL == name)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Lock the global queue list mutex */
+	os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+	/* Copy queue name into queue memory (NULL terminated by snprintf) */
+	snprintf(p->name, sizeof(p->name), "%s", name);
+
+	/* Unlock the global queue list mutex */
+	os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+	return 0;
+}
+
+static bool
+os_queue_listed(const os_queue_t *p)
+{
+	/* Caller holds the global queue list mutex */
+	for (const os_queue_t *tmp = g_queue_list; NULL != tmp; tmp = tmp->next)
+	{
+		if (p == tmp)
+			return true;
+	}
+
+	return false;
+}
+
+int
+os_queue_snapshot(os_queue_stat_t *p_stats, uint32_t max_count, uint32_t *p_count)
+{
+	os_queue_t *tmp = NULL;
+	uint32_t count = 0U;
+	uint64_t now;
+
+	if (NULL == p_count || (0U != max_count && NULL == p_stats))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Read the clock before locking to keep the critical section short */
+	now = os_prv_now_ns();
+
+	do
+	{
+		/* Lock the global queue list mutex */
+		os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+		/* Start at the list head, or resume where the previous batch stopped (if still listed) */
+		if (0U == count)
+			tmp = g_queue_list;
+		else if (!os_queue_listed(tmp))
+			tmp = NULL;
+
+		/* Copy a few fields of a bounded number of queues, so senders never wait for the whole list */
+		for (uint32_t n = 0U; NULL != tmp && n < QUEUE_SNAPSHOT_BATCH; tmp = tmp->next, n++, count++)
+		{
+			os_queue_stat_t *stat;
+
+			if (count >= max_count)
+				continue;
+
+			stat = &p_stats[count];
+
+			stat->queue		= tmp;
+			stat->depth		= (tmp->tail - tmp->head) & tmp->size;
+			stat->capacity	= tmp->size;
+			stat->sub_count = tmp->sub_count;
+
+			memcpy(stat->name, tmp->name, sizeof(stat->name));
+
+			/* The message at the head cursor is the oldest one waiting */
+			if (0U != stat->depth && now > tmp->buffer[tmp->head].timestamp)
+				stat->oldest_age_ns = now - tmp->buffer[tmp->head].timestamp;
+			else
+				stat->oldest_age_ns = 0U;
+		}
+
+		/* Unlock the global queue list mutex */
+		os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+	} while (NULL != tmp);
+
+	*p_count = count;
+
+	return 0;
+}
+
 int
 os_queue_sub(os_queue_t *p, uint32_t id)
 {
 	uint32_t off = id / 32U;
-	uint32_t bit = id & 7U;
+	uint32_t bit = id & 31U;
 
 	if (NULL == p || id > (OS_QUEUE_MSGID_MAX-1U))
 	{
@@ -135,6 +340,24 @@ os_queue_sub(os_queue_t *p, uint32_t id)
 	/* Lock the global queue list mutex */
 	os_assert(0 == os_mutex_lock(&g_queue_mutex));
 
+	/* Queue was never initialized or has been destroyed */
+	if (NULL == p->subscriptions)
+	{
+		os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Count the new subscriber (only if not already subscribed) */
+	if (0U == ((p->subscriptions[off] >> bit) & 1U))
+	{
+		g_queue_sub_count[id]++;
+		p->sub_count++;
+	}
+
 	/* Enable notifications for this message ID */
 	p->subscriptions[off] |= (1U << bit);
 
@@ -148,7 +371,7 @@ int
 os_queue_unsub(os_queue_t *p, uint32_t id)
 {
 	uint32_t off = id / 32U;
-	uint32_t bit = id & 7U;
+	uint32_t bit = id & 31U;
 
 	if (NULL == p || id > (OS_QUEUE_MSGID_MAX-1U))
 	{
@@ -161,6 +384,24 @@ os_queue_unsub(os_queue_t *p, uint32_t id)
 	/* Lock the global queue list mutex */
 	os_assert(0 == os_mutex_lock(&g_queue_mutex));
 
+	/* Queue was never initialized or has been destroyed */
+	if (NULL == p->subscriptions)
+	{
+		os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Remove the subscriber count (only if currently subscribed) */
+	if (0U != ((p->subscriptions[off] >> bit) & 1U))
+	{
+		g_queue_sub_count[id]--;
+		p->sub_count--;
+	}
+
 	/* Disable notifications for this message ID */
 	p->subscriptions[off] &= ~(1U << bit);
 
@@ -223,6 +464,9 @@ os_queue_send(os_queue_t *p, os_msg_t *msg)
 		return -1;
 	}
 
+	/* Stamp the message so the queue's oldest message age can be reported (clock read outside the lock) */
+	msg->timestamp = os_prv_now_ns();
+
 	/* Lock the global queue list mutex */
 	os_assert(0 == os_mutex_lock(&g_queue_mutex));
 
@@ -246,6 +490,68 @@ os_queue_send(os_queue_t *p, os_msg_t *msg)
 			/* Found target queue; set error to 0 indicating queue found */
 			err = 0;
 
+			/* Append to the traffic recording (if enabled) */
+			os_queue_record(OS_QREC_TYPE_SEND, msg, QUEUE_USED_UNKNOWN);
+
+			break;
+		}
+
+		tmp = tmp->next;
+	}
+
+	/* Unlock the global queue list mutex */
+	os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+	/* Condition when no queue was found in list */
+	if (-2 == err)
+	{
+		/* Set os_errno to indicate no queue found in list */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	return err;
+}
+
+static int
+os_queue_send_params(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t param_count,
+	const uint32_t *params, bool zero)
+{
+	os_queue_t *tmp;
+	uint64_t now;
+	int err = -2;	// Local to this func, -2 = no queue found
+
+	if (NULL == p || NULL == dst || param_count > OS_QUEUE_PARAM_COUNT || (0U != param_count && NULL == params))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Read the clock before locking to keep the critical section short */
+	now = os_prv_now_ns();
+
+	/* Lock the global queue list mutex */
+	os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+	/* Grab address of first queue in global queue list */
+	tmp = g_queue_list;
+
+	/* Traverse the queue list, find the queue by address */
+	while (NULL != tmp)
+	{
+		if (dst == tmp)
+		{
+			os_msg_t *slot = os_queue_write(tmp, p, dst, userdata, id, param_count, params, zero, now);
+
+			/* Found target queue; set error to 0 indicating queue found */
+			err = 0;
+
+			/* Append to the traffic recording (if enabled) */
+			os_queue_record(OS_QREC_TYPE_SEND, slot, param_count * sizeof(uint32_t));
+
 			break;
 		}
 
@@ -267,10 +573,16 @@ os_queue_send(os_queue_t *p, os_msg_t *msg)
 	return err;
 }
 
+int
+os_queue_sendn(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t param_count, const uint32_t *params)
+{
+	return os_queue_send_params(p, dst, userdata, id, param_count, params, false);
+}
+
 int
 os_queue_sendv(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, uint32_t param_count, ...)
 {
-	os_msg_t qmsg;
+	uint32_t params[OS_QUEUE_PARAM_COUNT];
 	va_list  argp;
 
 	if (NULL == p || NULL == dst || param_count > OS_QUEUE_PARAM_COUNT)
@@ -281,26 +593,18 @@ os_queue_sendv(os_queue_t *p, os_queue_t *dst, uint32_t userdata, uint32_t id, u
 		return -1;
 	}
 
-	memset(&qmsg, 0, sizeof(qmsg));
-
-	/* Save the message params */
-	qmsg.userdata = userdata;
-	qmsg.source	  = p;
-	qmsg.target   = dst;
-	qmsg.id 	  = id;
-
 	/* Start the stack varargs list */
 	va_start(argp, param_count);
 
-	/* Copy params from stack to the message buffer */
+	/* Copy params from stack to the params array (only the used params) */
 	for (uint32_t i = 0U; i < param_count; i++)
-		qmsg.params[i] = va_arg(argp, uint32_t);
+		params[i] = va_arg(argp, uint32_t);
 
 	/* End the stack list */
 	va_end(argp);
 
-	/* Post the actual message */
-	return os_queue_send(p, &qmsg);
+	/* Send the actual message (unused params are zeroed, as before os_queue_sendn() existed) */
+	return os_queue_send_params(p, dst, userdata, id, param_count, params, true);
 }
 
 int
@@ -320,7 +624,10 @@ os_queue_post(os_queue_t *p, os_msg_t *msg)
 
 	/* Calculate subscriptions table index and bit */
 	off = msg->id / 32U;
-	bit = msg->id & 7U;
+	bit = msg->id & 31U;
+
+	/* Stamp the message so the queue's oldest message age can be reported (clock read outside the lock) */
+	msg->timestamp = os_prv_now_ns();
 
 	/* Lock the global queue list mutex */
 	os_assert(0 == os_mutex_lock(&g_queue_mutex));
@@ -328,8 +635,11 @@ os_queue_post(os_queue_t *p, os_msg_t *msg)
 	/* Ensure the 'source' field is pointing to the correct queue */
 	msg->source = p;
 
-	/* Grab address of first queue in global queue list */
-	tmp = g_queue_list;
+	/* Append to the traffic recording (if enabled) */
+	os_queue_record(OS_QREC_TYPE_POST, msg, QUEUE_USED_UNKNOWN);
+
+	/* Skip the list walk entirely when nobody subscribed to this message ID */
+	tmp = (0U != g_queue_sub_count[msg->id]) ? g_queue_list : NULL;
 
 	/* Traverse the queue list, find the queue by address */
 	while (NULL != tmp)
@@ -353,10 +663,85 @@ os_queue_post(os_queue_t *p, os_msg_t *msg)
 	return 0;
 }
 
+static int
+os_queue_post_params(os_queue_t *p, uint32_t id, uint32_t param_count, const uint32_t *params, bool zero)
+{
+	os_queue_t *tmp;
+	os_msg_t   *slot = NULL;
+	uint64_t now;
+	uint32_t off;
+	uint32_t bit;
+
+	if (NULL == p || id > (OS_QUEUE_MSGID_MAX-1U) || param_count > OS_QUEUE_PARAM_COUNT ||
+		(0U != param_count && NULL == params))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Read the clock once, before locking; every subscriber gets the same timestamp */
+	now = os_prv_now_ns();
+
+	/* Calculate subscriptions table index and bit */
+	off = id / 32U;
+	bit = id & 31U;
+
+	/* Lock the global queue list mutex */
+	os_assert(0 == os_mutex_lock(&g_queue_mutex));
+
+	/* Skip the list walk entirely when nobody subscribed to this message ID */
+	tmp = (0U != g_queue_sub_count[id]) ? g_queue_list : NULL;
+
+	/* Traverse the queue list, find the subscribed queues */
+	while (NULL != tmp)
+	{
+		/* Only notify if the queue is subscribed to this event */
+		if (0U != ((tmp->subscriptions[off] >> bit) & 1U))
+			slot = os_queue_write(tmp, p, NULL, 0U, id, param_count, params, zero, now);
+
+		tmp = tmp->next;
+	}
+
+	/* Append to the traffic recording (if enabled) */
+	if (NULL != slot)
+	{
+		os_queue_record(OS_QREC_TYPE_POST, slot, param_count * sizeof(uint32_t));
+	}
+	else if (NULL != __atomic_load_n(&g_queue_recorder, __ATOMIC_ACQUIRE))
+	{
+		os_msg_t qmsg;
+
+		/* No subscriber slot to record from; build the used part of the message */
+		qmsg.source	  = p;
+		qmsg.target	  = NULL;
+		qmsg.userdata = 0U;
+		qmsg.id		  = id;
+		qmsg.timestamp = now;
+
+		if (0U != param_count)
+			memcpy(qmsg.params, params, param_count * sizeof(uint32_t));
+
+		os_queue_record(OS_QREC_TYPE_POST, &qmsg, param_count * sizeof(uint32_t));
+	}
+
+	/* Unlock the global queue list mutex */
+	os_assert(0 == os_mutex_unlock(&g_queue_mutex));
+
+	return 0;
+}
+
+int
+os_queue_postn(os_queue_t *p, uint32_t id, uint32_t param_count, const uint32_t *params)
+{
+	return os_queue_post_params(p, id, param_count, params, false);
+}
+
 int
 os_queue_postv(os_queue_t *p, uint32_t id, uint32_t param_count, ...)
 {
-	os_msg_t qmsg;
+	uint32_t params[OS_QUEUE_PARAM_COUNT];
 	va_list  argp;
 
 	if (NULL == p || param_count > OS_QUEUE_PARAM_COUNT)
@@ -367,23 +752,16 @@ os_queue_postv(os_queue_t *p, uint32_t id, uint32_t param_count, ...)
 		return -1;
 	}
 
-	memset(&qmsg, 0, sizeof(qmsg));
-
-	/* Save the message information */
-	qmsg.source = p;
-	qmsg.target = NULL;
-	qmsg.id = id;
-
 	/* Start the stack varargs list */
 	va_start(argp, param_count);
 
-	/* Copy params from stack to the message buffer */
+	/* Copy params from stack to the params array (only the used params) */
 	for (uint32_t i = 0U; i < param_count; i++)
-		qmsg.params[i] = va_arg(argp, uint32_t);
+		params[i] = va_arg(argp, uint32_t);
 
 	/* End the stack list */
 	va_end(argp);
 
-	/* Post the actual message */
-	return os_queue_post(p, &qmsg);
+	/* Post the actual message (unused params are zeroed, as before os_queue_postn() existed) */
+	return os_queue_post_params(p, id, param_count, params, true);
 }
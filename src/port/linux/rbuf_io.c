@@ -0,0 +1,153 @@
+#include "../../../inc/rbuf.h"
+#include "../../../inc/errno.h"
+
+#include "../../private.h"
+
+#include <sys/uio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+/* ------------------------------------------------------------ */
+
+static int
+os_rbuf_iov(const os_rbuf_span_t spans[2], int count, uint32_t max, struct iovec iov[2])
+{
+	uint32_t left = (0U == max) ? UINT32_MAX : max;
+	int n = 0;
+
+	/* Convert spans to I/O vectors, limited to 'max' bytes */
+	for (int i = 0; i < count && 0U != left; i++, n++)
+	{
+		uint32_t len = (spans[i].len < left) ? spans[i].len : left;
+
+		iov[i].iov_base = spans[i].data;
+		iov[i].iov_len	= len;
+
+		left -= len;
+	}
+
+	return n;
+}
+
+static void
+os_rbuf_io_errno()
+{
+	/* Translate errno from readv()/writev() */
+	if (EAGAIN == errno || EWOULDBLOCK == errno)
+		os_errno = OS_EAGAIN;
+	else if (EBADF == errno || EINVAL == errno || EFAULT == errno)
+		os_errno = OS_EINVAL;
+	else
+		os_errno = OS_EERROR;
+}
+
+int
+os_rbuf_read_fd(os_rbuf_t *p, int fd, uint32_t max, uint32_t *p_count)
+{
+	os_rbuf_span_t spans[2];
+	struct iovec   iov[2];
+	ssize_t ret;
+	int		n;
+
+	if (NULL == p || fd < 0)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (NULL != p_count)
+		*p_count = 0U;
+
+	/* Free space of the ring buffer (up to two regions) */
+	n = os_rbuf_write_spans(p, spans);
+	if (0 == n)
+	{
+		/* Indicate buffer is full */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	n = os_rbuf_iov(spans, n, max, iov);
+
+	/* Read straight into the pool; retry if interrupted by a signal */
+	do
+	{
+		ret = readv(fd, iov, n);
+	} while (-1 == ret && EINTR == errno);
+
+	if (-1 == ret)
+	{
+		OS_PRV_DBG("os_rbuf_read_fd(): readv() failed: %d", errno);
+
+		os_rbuf_io_errno();
+
+		return -1;
+	}
+
+	/* Commit the bytes read into the pool */
+	os_rbuf_produce(p, (uint32_t) ret);
+
+	if (NULL != p_count)
+		*p_count = (uint32_t) ret;
+
+	return 0;
+}
+
+int
+os_rbuf_write_fd(os_rbuf_t *p, int fd, uint32_t max, uint32_t *p_count)
+{
+	os_rbuf_span_t spans[2];
+	struct iovec   iov[2];
+	ssize_t ret;
+	int		n;
+
+	if (NULL == p || fd < 0)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (NULL != p_count)
+		*p_count = 0U;
+
+	/* Used data of the ring buffer (up to two regions) */
+	n = os_rbuf_read_spans(p, spans);
+	if (0 == n)
+	{
+		/* Set os_errno to indicate no data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	n = os_rbuf_iov(spans, n, max, iov);
+
+	/* Write straight from the pool; retry if interrupted by a signal */
+	do
+	{
+		ret = writev(fd, iov, n);
+	} while (-1 == ret && EINTR == errno);
+
+	if (-1 == ret)
+	{
+		OS_PRV_DBG("os_rbuf_write_fd(): writev() failed: %d", errno);
+
+		os_rbuf_io_errno();
+
+		return -1;
+	}
+
+	/* Release the bytes written from the pool */
+	os_rbuf_consume(p, (uint32_t) ret);
+
+	if (NULL != p_count)
+		*p_count = (uint32_t) ret;
+
+	return 0;
+}
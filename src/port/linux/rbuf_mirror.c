@@ -0,0 +1,129 @@
+#define _GNU_SOURCE
+
+#include "../../../inc/rbuf.h"
+#include "../../../inc/errno.h"
+
+#include "../../private.h"
+
+#include <sys/mman.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+/* ------------------------------------------------------------ */
+
+int
+os_rbuf_mirror_init(os_rbuf_t *p, uint32_t pool_size)
+{
+	long	 page = sysconf(_SC_PAGESIZE);
+	uint8_t *base;
+	void	*map;
+	int		 fd;
+
+	if (NULL == p || 0U == pool_size || page <= 0L)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Byte pool size must be power of 2 for cursor calculation logic, and page aligned for mapping */
+	if (0U != (pool_size & (pool_size - 1U)) || 0U != (pool_size % (uint32_t) page))
+	{
+		OS_PRV_ERR("os_rbuf_mirror_init(): pool_size is not a power of 2 multiple of the page size");
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Anonymous file backing both views of the pool */
+	fd = memfd_create("os_rbuf", MFD_CLOEXEC);
+	if (-1 == fd)
+	{
+		OS_PRV_ERR("os_rbuf_mirror_init(): memfd_create() failed: %d", errno);
+
+		/* Set os_errno to indicate unable to allocate memory */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	if (-1 == ftruncate(fd, (off_t) pool_size))
+	{
+		close(fd);
+
+		/* Set os_errno to indicate unable to allocate memory */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	/* Reserve twice the pool size of contiguous address space */
+	base = mmap(NULL, (size_t) pool_size * 2U, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (MAP_FAILED == base)
+	{
+		close(fd);
+
+		/* Set os_errno to indicate unable to allocate memory */
+		os_errno = OS_ENOMEM;
+
+		return -1;
+	}
+
+	/* Map the pool into both halves of the reservation */
+	for (uint32_t i = 0U; i < 2U; i++)
+	{
+		map = mmap(base + ((size_t) pool_size * i), pool_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_FIXED, fd, 0);
+
+		if (MAP_FAILED == map)
+		{
+			munmap(base, (size_t) pool_size * 2U);
+			close(fd);
+
+			/* Set os_errno to indicate unable to allocate memory */
+			os_errno = OS_ENOMEM;
+
+			return -1;
+		}
+	}
+
+	/* The mappings keep the file alive */
+	close(fd);
+
+	if (-1 == os_rbuf_init(p, base, pool_size))
+	{
+		munmap(base, (size_t) pool_size * 2U);
+
+		return -1;
+	}
+
+	p->flags |= OS_RBUF_F_MIRROR;
+
+	return 0;
+}
+
+int
+os_rbuf_mirror_destroy(os_rbuf_t *p)
+{
+	if (NULL == p || 0U == (p->flags & OS_RBUF_F_MIRROR))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Unmap both views of the pool */
+	munmap(p->pool, ((size_t) p->size + 1U) * 2U);
+
+	/* Clear memory */
+	memset(p, 0, sizeof(*p));
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include "../../../inc/rbuf_spsc.h"
+#include "../../../inc/errno.h"
+#include "../../../inc/task.h"
+#include "../../../inc/time.h"
+
+#include "../../private.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* ------------------------------------------------------------ */
+
+void
+os_rbuf_spsc_wake(uint32_t *p_cursor)
+{
+	/* Wake the (single) thread blocked on the cursor */
+	syscall(SYS_futex, p_cursor, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+static bool
+os_rbuf_spsc_ready(os_rbuf_spsc_t *p, uint32_t count, bool used, uint32_t *p_cursor)
+{
+	uint32_t head = __atomic_load_n(&p->head, __ATOMIC_SEQ_CST);
+	uint32_t tail = __atomic_load_n(&p->tail, __ATOMIC_SEQ_CST);
+
+	/* Remember the value of the cursor the other side advances */
+	*p_cursor = used ? tail : head;
+
+	if (used)
+		return ((tail - head) & p->size) >= count;
+
+	return (((head - tail) - 1U) & p->size) >= count;
+}
+
+static int
+os_rbuf_spsc_wait(os_rbuf_spsc_t *p, uint32_t count, long timeout_ms, bool used)
+{
+	uint32_t *p_waiters;
+	uint32_t *p_word;
+	os_time_t deadline	= OS_TIME_INIT;
+	uint32_t  cursor;
+	int		  ret;
+
+	if (NULL == p || 0U == count || count > p->size)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (!p->waitable)
+	{
+		/* Set os_errno to indicate the ring does not wake waiters */
+		os_errno = OS_ENOSUP;
+
+		return -1;
+	}
+
+	p_waiters = used ? &p->used_waiters : &p->free_waiters;
+	p_word	  = used ? &p->tail : &p->head;
+
+	/* Fast path; no system call when the condition already holds */
+	if (os_rbuf_spsc_ready(p, count, used, &cursor))
+		return 0;
+
+	if (0 == timeout_ms)
+	{
+		/* Set os_errno to indicate the wait timed out */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	if (timeout_ms > 0)
+		deadline = os_time_add_ms(os_time_monotonic(), timeout_ms);
+
+	while (1)
+	{
+		/* Announce the waiter before re-checking, so a concurrent push/pop sees it */
+		__atomic_fetch_add(p_waiters, 1U, __ATOMIC_SEQ_CST);
+
+		if (os_rbuf_spsc_ready(p, count, used, &cursor))
+		{
+			__atomic_fetch_sub(p_waiters, 1U, __ATOMIC_SEQ_CST);
+
+			return 0;
+		}
+
+		/* Sleep until the cursor moves or the calling task is asked to stop */
+		ret = os_prv_task_futex_wait(p_word, cursor, (timeout_ms > 0) ? &deadline : NULL);
+
+		__atomic_fetch_sub(p_waiters, 1U, __ATOMIC_SEQ_CST);
+
+		if (os_rbuf_spsc_ready(p, count, used, &cursor))
+			return 0;
+
+		if (-1 == ret || os_task_check_stop(os_prv_task_self()))
+		{
+			/* Set os_errno to indicate the wait timed out or the task is stopping */
+			os_errno = OS_EAGAIN;
+
+			return -1;
+		}
+	}
+}
+
+int
+os_rbuf_spsc_wait_used(os_rbuf_spsc_t *p, uint32_t count, long timeout_ms)
+{
+	return os_rbuf_spsc_wait(p, count, timeout_ms, true);
+}
+
+int
+os_rbuf_spsc_wait_free(os_rbuf_spsc_t *p, uint32_t count, long timeout_ms)
+{
+	return os_rbuf_spsc_wait(p, count, timeout_ms, false);
+}
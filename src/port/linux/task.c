@@ -1,19 +1,38 @@
+#define _GNU_SOURCE
+
 #include "../../../inc/task.h"
 #include "../../../inc/errno.h"
+#include "../../../inc/time.h"
+
+#include "../../private.h"
 
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+/* Without futex_waitv(), a task blocked in a library wait re-checks its stop word this often */
+#define TASK_STOP_POLL_MS 10U
+
+/* Task running on the current thread (NULL for threads not started by os_task_create()) */
+static __thread os_task_t *t_task_self;
 
 /* ------------------------------------------------------------ */
 
 int
-os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg)
+os_task_attr_init(os_task_attr_t *attr)
 {
-	if (NULL == p || NULL == name)
+	if (NULL == attr)
 	{
 		/* Set os_errno to indicate invalid arguments */
 		os_errno = OS_EINVAL;
@@ -21,24 +40,145 @@ os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func
 		return -1;
 	}
 
+	/* Clear out attribute memory (no CPU set, default stack) */
+	memset(attr, 0, sizeof(*attr));
+
+	attr->policy   = SCHED_OTHER;
+	attr->priority = 0;
+
+	return 0;
+}
+
+int
+os_task_attr_set_cpu(os_task_attr_t *attr, uint32_t cpu)
+{
+	if (NULL == attr || cpu >= OS_TASK_CPU_MAX)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	attr->cpus[cpu / 64U] |= (uint64_t) 1U << (cpu % 64U);
+
+	return 0;
+}
+
+static int
+os_task_attr_apply(pthread_attr_t *pattr, const os_task_attr_t *attr)
+{
+	struct sched_param param = { .sched_priority = attr->priority };
+	cpu_set_t cpus;
+	bool affinity = false;
+
+	CPU_ZERO(&cpus);
+
+	for (uint32_t cpu = 0U; cpu < OS_TASK_CPU_MAX; cpu++)
+	{
+		if (0U != (attr->cpus[cpu / 64U] & ((uint64_t) 1U << (cpu % 64U))))
+		{
+			CPU_SET(cpu, &cpus);
+
+			affinity = true;
+		}
+	}
+
+	/* Pin the thread before it first runs */
+	if (affinity && 0 != pthread_attr_setaffinity_np(pattr, sizeof(cpus), &cpus))
+		return -1;
+
+	/* Use the requested policy instead of inheriting the creator's */
+	if (0 != pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED) ||
+		0 != pthread_attr_setschedpolicy(pattr, attr->policy) ||
+		0 != pthread_attr_setschedparam(pattr, &param))
+		return -1;
+
+	if (0U != attr->stack_size && 0 != pthread_attr_setstacksize(pattr, attr->stack_size))
+		return -1;
+
+	if (0U != attr->guard_size && 0 != pthread_attr_setguardsize(pattr, attr->guard_size))
+		return -1;
+
+	return 0;
+}
+
+static void *
+os_task_entry(void *param)
+{
+	os_task_t *p = param;
+	char name[16U];
+
+	/* Record the kernel thread ID for os_task_stats() */
+	__atomic_store_n(&p->tid, (int32_t) syscall(SYS_gettid), __ATOMIC_RELEASE);
+
+	/* Lets library waits on this thread also wake on os_task_stop() */
+	t_task_self = p;
+
+	/* Kernel thread names are limited to 15 characters */
+	snprintf(name, sizeof(name), "%.15s", p->name);
+	pthread_setname_np(pthread_self(), name);
+
+	return p->p_func(p->p_func_arg);
+}
+
+int
+os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg)
+{
+	return os_task_init_ex(p, name, p_func, p_func_arg, NULL);
+}
+
+static void
+os_task_setup(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg)
+{
 	/* Clear out new task memory */
 	memset(p, 0, sizeof(os_task_t));
 
 	/* Copy task name into task control block memory (NULL terminated by snprintf) */
 	snprintf(p->name, sizeof(p->name), "%s", name);
 
-	/* Initialize mutex memory */
-	p->mutex = (pthread_mutex_t) PTHREAD_MUTEX_INITIALIZER;
+	/* No stop event descriptor until one is requested */
+	p->stop_fd = -1;
 
-	/* Store address of task function and function argument */
+	/* Store address of task function and function argument (called by os_task_entry()) */
 	p->p_func	  = p_func;
 	p->p_func_arg = p_func_arg;
+}
+
+static int
+os_task_create(os_task_t *p, const os_task_attr_t *attr)
+{
+	pthread_attr_t pattr;
+	int err;
+
+	pthread_attr_init(&pattr);
+
+	if (NULL != attr && -1 == os_task_attr_apply(&pattr, attr))
+	{
+		pthread_attr_destroy(&pattr);
+
+		/* Set os_errno to indicate invalid attributes */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
 
 	/* Create the new task thread */
-	if (0 != pthread_create(&p->thread, NULL, p->p_func, p->p_func_arg))
+	err = pthread_create(&p->thread, &pattr, os_task_entry, p);
+
+	pthread_attr_destroy(&pattr);
+
+	if (0 != err)
 	{
-		/* Set os_errno to generic error */
-		os_errno = OS_EERROR;
+		OS_PRV_ERR("os_task_create(): pthread_create() failed: %d", err);
+
+		/* Set os_errno to indicate the reason the thread could not be created */
+		if (EPERM == err)
+			os_errno = OS_EPERM;
+		else if (EINVAL == err)
+			os_errno = OS_EINVAL;
+		else
+			os_errno = OS_EERROR;
 
 		return -1;
 	}
@@ -47,9 +187,191 @@ os_task_init(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func
 }
 
 int
-os_task_destroy(os_task_t *p)
+os_task_init_ex(os_task_t *p, const char *name, os_task_func_f p_func, void *p_func_arg, const os_task_attr_t *attr)
 {
-	if (NULL == p)
+	if (NULL == p || NULL == name)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	os_task_setup(p, name, p_func, p_func_arg);
+
+	return os_task_create(p, attr);
+}
+
+static bool
+os_task_wait_until(os_task_t *p, const os_time_t *deadline)
+{
+	while (0U == __atomic_load_n(&p->stop, __ATOMIC_ACQUIRE))
+	{
+		/* Sleep while the stop word is 0 (absolute CLOCK_MONOTONIC deadline, NULL = none) */
+		if (-1 == syscall(SYS_futex, &p->stop, FUTEX_WAIT_BITSET_PRIVATE, 0U, deadline, NULL, FUTEX_BITSET_MATCH_ANY) &&
+			ETIMEDOUT == errno)
+		{
+			return os_task_check_stop(p);
+		}
+	}
+
+	return true;
+}
+
+os_task_t *
+os_prv_task_self()
+{
+	return t_task_self;
+}
+
+int
+os_prv_task_futex_wait(uint32_t *p_word, uint32_t value, const os_time_t *deadline)
+{
+	os_task_t *self = t_task_self;
+	os_time_t slice;
+	bool sliced = false;
+	long ret;
+
+#ifdef SYS_futex_waitv
+	if (NULL != self)
+	{
+		struct futex_waitv waiters[2U] = {
+			{ .val = value, .uaddr = (uintptr_t) p_word, .flags = FUTEX_32 | FUTEX_PRIVATE_FLAG },
+			{ .val = 0U, .uaddr = (uintptr_t) &self->stop, .flags = FUTEX_32 | FUTEX_PRIVATE_FLAG },
+		};
+
+		/* Sleep on the word and the stop word at once; os_task_stop() wakes the latter */
+		ret = syscall(SYS_futex_waitv, waiters, 2U, 0U, deadline, CLOCK_MONOTONIC);
+		if (-1 != ret || ENOSYS != errno)
+			return (-1 == ret && ETIMEDOUT == errno) ? -1 : 0;
+	}
+#endif
+
+	/* Kernel without futex_waitv(): bound the sleep so a task still notices a stop request */
+	if (NULL != self)
+	{
+		if (os_task_check_stop(self))
+			return 0;
+
+		slice = os_time_add_ms(os_time_monotonic(), TASK_STOP_POLL_MS);
+		if (NULL == deadline || os_time_cmp(slice, <, *deadline))
+		{
+			deadline = &slice;
+			sliced	 = true;
+		}
+	}
+
+	ret = syscall(SYS_futex, p_word, FUTEX_WAIT_BITSET_PRIVATE, value, deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+
+	return (-1 == ret && ETIMEDOUT == errno && !sliced) ? -1 : 0;
+}
+
+static void
+os_task_period_publish(os_task_t *p, const os_task_period_stats_t *st)
+{
+	os_task_period_stats_t *dst = &p->period.stats;
+	uint32_t seq = p->period.seq;
+
+	/*
+	 * Odd sequence: readers retry until the update is complete. Release stores keep the
+	 * odd sequence visible to any reader that loads one of the new values.
+	*/
+	__atomic_store_n(&p->period.seq, seq + 1U, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&dst->cycles, st->cycles, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->overruns, st->overruns, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->skipped, st->skipped, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->jitter_min_ns, st->jitter_min_ns, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->jitter_max_ns, st->jitter_max_ns, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->jitter_avg_ns, st->jitter_avg_ns, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->exec_max_ns, st->exec_max_ns, __ATOMIC_RELEASE);
+	__atomic_store_n(&dst->exec_last_ns, st->exec_last_ns, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&p->period.seq, seq + 2U, __ATOMIC_RELEASE);
+}
+
+static void *
+os_task_periodic_main(void *param)
+{
+	os_task_t *p = param;
+	os_task_period_t *per = &p->period;
+	os_task_period_stats_t st;
+	uint64_t jitter_sum = 0U;
+	uint64_t release;
+
+	memset(&st, 0, sizeof(st));
+
+	/* First cycle is released immediately */
+	release = os_prv_now_ns();
+
+	while (!os_task_check_stop(p))
+	{
+		uint64_t start = os_prv_now_ns();
+		uint64_t jitter = (start > release) ? start - release : 0U;
+		uint64_t end;
+
+		per->p_func(per->p_func_arg);
+
+		end = os_prv_now_ns();
+
+		os_task_heartbeat(p);
+
+		/* Update statistics of this cycle */
+		st.cycles++;
+
+		if (end > release + per->deadline_ns)
+			st.overruns++;
+
+		if (1U == st.cycles || jitter < st.jitter_min_ns)
+			st.jitter_min_ns = jitter;
+
+		if (jitter > st.jitter_max_ns)
+			st.jitter_max_ns = jitter;
+
+		jitter_sum		 += jitter;
+		st.jitter_avg_ns  = jitter_sum / st.cycles;
+
+		st.exec_last_ns = end - start;
+
+		if (st.exec_last_ns > st.exec_max_ns)
+			st.exec_max_ns = st.exec_last_ns;
+
+		/* Next release time; fixed grid, so cycle times do not accumulate as drift */
+		release += per->period_ns;
+
+		if (end >= release && OS_TASK_MISS_SKIP == per->miss)
+		{
+			/* Drop the release times already passed and realign to the grid */
+			uint64_t missed = ((end - release) / per->period_ns) + 1U;
+
+			st.skipped += missed;
+			release	   += missed * per->period_ns;
+		}
+
+		os_task_period_publish(p, &st);
+
+		/* Catch-up runs late cycles immediately */
+		if (end < release)
+		{
+			os_time_t deadline = {
+				.tv_sec	 = (time_t)(release / 1000000000U),
+				.tv_nsec = (long)(release % 1000000000U)
+			};
+
+			if (os_task_wait_until(p, &deadline))
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+int
+os_task_init_periodic(os_task_t *p, const char *name, os_task_cycle_f p_func, void *p_func_arg,
+					  long period_us, long deadline_us, OS_TASK_MISS miss, const os_task_attr_t *attr)
+{
+	if (NULL == p || NULL == name || NULL == p_func || period_us < 1L || deadline_us < 0L ||
+		(OS_TASK_MISS_SKIP != miss && OS_TASK_MISS_CATCHUP != miss))
 	{
 		/* Set os_errno to indicate invalid arguments */
 		os_errno = OS_EINVAL;
@@ -57,27 +379,67 @@ os_task_destroy(os_task_t *p)
 		return -1;
 	}
 
-	/* Obtain the task's control block mutex */
-	if (0 != pthread_mutex_lock(&p->mutex))
+	os_task_setup(p, name, os_task_periodic_main, p);
+
+	/* Cycle function is called by os_task_periodic_main() */
+	p->period.p_func	  = p_func;
+	p->period.p_func_arg  = p_func_arg;
+	p->period.period_ns	  = (uint64_t) period_us * 1000U;
+	p->period.deadline_ns = (uint64_t)((0L == deadline_us) ? period_us : deadline_us) * 1000U;
+	p->period.miss		  = miss;
+
+	return os_task_create(p, attr);
+}
+
+int
+os_task_period_stats(os_task_t *p, os_task_period_stats_t *p_stats)
+{
+	const os_task_period_stats_t *src;
+	uint32_t seq;
+
+	if (NULL == p || NULL == p_stats || NULL == p->period.p_func)
 	{
-		/* Set os_errno to indicate unable to obtain/release resource mutex */
-		os_errno = OS_EMUTEX;
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
 
 		return -1;
 	}
 
-	/* Set the exiting flag to inform task thread to exit */
-	p->f_exiting = 1U;
+	src = &p->period.stats;
+
+	/* Retry until the copy was not overlapped by an update */
+	do
+	{
+		while (0U != ((seq = __atomic_load_n(&p->period.seq, __ATOMIC_ACQUIRE)) & 1U))
+			sched_yield();
+
+		p_stats->cycles		   = __atomic_load_n(&src->cycles, __ATOMIC_ACQUIRE);
+		p_stats->overruns	   = __atomic_load_n(&src->overruns, __ATOMIC_ACQUIRE);
+		p_stats->skipped	   = __atomic_load_n(&src->skipped, __ATOMIC_ACQUIRE);
+		p_stats->jitter_min_ns = __atomic_load_n(&src->jitter_min_ns, __ATOMIC_ACQUIRE);
+		p_stats->jitter_max_ns = __atomic_load_n(&src->jitter_max_ns, __ATOMIC_ACQUIRE);
+		p_stats->jitter_avg_ns = __atomic_load_n(&src->jitter_avg_ns, __ATOMIC_ACQUIRE);
+		p_stats->exec_max_ns   = __atomic_load_n(&src->exec_max_ns, __ATOMIC_ACQUIRE);
+		p_stats->exec_last_ns  = __atomic_load_n(&src->exec_last_ns, __ATOMIC_ACQUIRE);
+	} while (seq != __atomic_load_n(&p->period.seq, __ATOMIC_RELAXED));
 
-	/* Release the task's control block mutex */
-	if (0 != pthread_mutex_unlock(&p->mutex))
+	return 0;
+}
+
+int
+os_task_destroy(os_task_t *p)
+{
+	if (NULL == p)
 	{
-		/* Set os_errno to indicate unable to obtain/release resource mutex */
-		os_errno = OS_EMUTEX;
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
 
 		return -1;
 	}
 
+	/* Inform task thread to exit (wakes it if it is waiting) */
+	os_task_stop(p);
+
 	/* Join the task's pthread to cleanup resources */
 	if (0 != pthread_join(p->thread, NULL))
 	{
@@ -87,6 +449,9 @@ os_task_destroy(os_task_t *p)
 		return -1;
 	}
 
+	if (-1 != p->stop_fd)
+		close(p->stop_fd);
+
 	/* Clear memory */
 	memset(p, 0, sizeof(*p));
 
@@ -96,21 +461,192 @@ os_task_destroy(os_task_t *p)
 bool
 os_task_check_stop(os_task_t *p)
 {
-	bool retval = false;
-
 	if (NULL == p)
 		return false;
 
-	/* Obtain the task's control block mutex */
-	if (0 != pthread_mutex_lock(&p->mutex))
-		return false;
+	return 0U != __atomic_load_n(&p->stop, __ATOMIC_ACQUIRE);
+}
+
+int
+os_task_stop(os_task_t *p)
+{
+	uint64_t one = 1U;
+	int fd;
+
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Set the stop word (ordered before the descriptor check below) */
+	__atomic_store_n(&p->stop, 1U, __ATOMIC_SEQ_CST);
+
+	/* Wake every thread blocked in os_task_wait_stop() */
+	syscall(SYS_futex, &p->stop, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+
+	/* Signal the stop event if one was handed out */
+	fd = __atomic_load_n(&p->stop_fd, __ATOMIC_SEQ_CST);
+	if (-1 != fd && sizeof(one) != write(fd, &one, sizeof(one)))
+	{
+		OS_PRV_WRN("os_task_stop(): write() failed: %d", errno);
+	}
+
+	return 0;
+}
 
-	/* Get the task exiting flag */
-	retval = p->f_exiting;
+bool
+os_task_wait_stop(os_task_t *p, long timeout_ms)
+{
+	os_time_t deadline;
 
-	/* Release the task's control block mutex */
-	if (0 != pthread_mutex_unlock(&p->mutex))
+	if (NULL == p)
 		return false;
 
-	return retval;
+	if (0 == timeout_ms)
+		return os_task_check_stop(p);
+
+	if (timeout_ms < 0)
+		return os_task_wait_until(p, NULL);
+
+	deadline = os_time_add_ms(os_time_monotonic(), timeout_ms);
+
+	return os_task_wait_until(p, &deadline);
+}
+
+int
+os_task_stop_fd(os_task_t *p)
+{
+	uint64_t one = 1U;
+	int expected = -1;
+	int fd;
+
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	fd = __atomic_load_n(&p->stop_fd, __ATOMIC_ACQUIRE);
+	if (-1 != fd)
+		return fd;
+
+	fd = eventfd(0U, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (-1 == fd)
+	{
+		/* Set os_errno to indicate the event could not be created */
+		os_errno = OS_EERROR;
+
+		return -1;
+	}
+
+	/* Another thread may have created the event meanwhile */
+	if (!__atomic_compare_exchange_n(&p->stop_fd, &expected, fd, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE))
+	{
+		close(fd);
+
+		return expected;
+	}
+
+	/* The stop may have been requested before the event existed */
+	if (0U != __atomic_load_n(&p->stop, __ATOMIC_SEQ_CST) && sizeof(one) != write(fd, &one, sizeof(one)))
+	{
+		OS_PRV_WRN("os_task_stop_fd(): write() failed: %d", errno);
+	}
+
+	return fd;
+}
+
+int
+os_task_stats(os_task_t *p, os_task_stats_t *p_stats)
+{
+	struct timespec ts;
+	clockid_t clock;
+	char path[64U];
+	char line[512U];
+	char *field;
+	FILE *fp;
+	int32_t tid;
+
+	if (NULL == p || NULL == p_stats)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	tid = __atomic_load_n(&p->tid, __ATOMIC_ACQUIRE);
+	if (0 == tid)
+	{
+		/* Set os_errno to indicate the task thread is not running yet */
+		os_errno = OS_EAGAIN;
+
+		return -1;
+	}
+
+	memset(p_stats, 0, sizeof(*p_stats));
+
+	p_stats->tid	  = tid;
+	p_stats->last_cpu = -1;
+
+	/* Per-thread CPU time */
+	if (0 != pthread_getcpuclockid(p->thread, &clock) || -1 == clock_gettime(clock, &ts))
+	{
+		/* Set os_errno to indicate the task thread is gone */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	p_stats->cpu_ns = ((uint64_t) ts.tv_sec * 1000000000U) + (uint64_t) ts.tv_nsec;
+
+	/* Context switch counters */
+	snprintf(path, sizeof(path), "/proc/self/task/%d/status", (int) tid);
+
+	fp = fopen(path, "r");
+	if (NULL == fp)
+	{
+		/* Set os_errno to indicate the task thread is gone */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	while (NULL != fgets(line, sizeof(line), fp))
+	{
+		unsigned long long value;
+
+		if (1 == sscanf(line, "voluntary_ctxt_switches: %llu", &value))
+			p_stats->voluntary_switches = value;
+		else if (1 == sscanf(line, "nonvoluntary_ctxt_switches: %llu", &value))
+			p_stats->involuntary_switches = value;
+	}
+
+	fclose(fp);
+
+	/* Last CPU is field 39 of stat; count fields after the (possibly spaced) comm field */
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int) tid);
+
+	fp = fopen(path, "r");
+	if (NULL != fp)
+	{
+		if (NULL != fgets(line, sizeof(line), fp) && NULL != (field = strrchr(line, ')')))
+		{
+			/* Field 3 (state) follows the closing parenthesis */
+			for (int n = 2; NULL != field && n < 39; n++)
+				field = strchr(field + 1, ' ');
+
+			if (NULL != field)
+				p_stats->last_cpu = (int32_t) strtol(field + 1, NULL, 10);
+		}
+
+		fclose(fp);
+	}
+
+	return 0;
 }
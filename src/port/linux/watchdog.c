@@ -0,0 +1,281 @@
+#include "../../../inc/watchdog.h"
+#include "../../../inc/assert.h"
+#include "../../../inc/errno.h"
+
+#include "../../private.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+/* Report produced by one heartbeat check */
+typedef struct
+{
+	char name[OS_TASK_NAME_SIZE + 1U];
+
+	int32_t tid;
+	uint64_t idle_ms;
+	bool stalled;
+} os_watchdog_report_t;
+
+/* ------------------------------------------------------------ */
+
+static uint32_t
+os_watchdog_check(os_watchdog_t *p, os_watchdog_report_t reports[OS_WATCHDOG_TASKS_MAX])
+{
+	uint64_t now = os_prv_now_ns();
+	uint32_t count = 0U;
+
+	os_assert(0 == os_mutex_lock(&(p->mutex)));
+
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		os_watchdog_entry_t *e = &p->entries[i];
+		uint64_t beat = __atomic_load_n(&e->task->heartbeat, __ATOMIC_RELAXED);
+		bool stalled;
+
+		if (beat != e->heartbeat)
+		{
+			e->heartbeat  = beat;
+			e->changed_ns = now;
+		}
+
+		stalled = (now - e->changed_ns) > e->budget_ns;
+
+		/* Report state changes only, not every check while stalled */
+		if (stalled == e->stalled)
+			continue;
+
+		e->stalled = stalled;
+
+		if (stalled)
+			p->stalls++;
+
+		snprintf(reports[count].name, sizeof(reports[count].name), "%s", e->task->name);
+
+		reports[count].tid	   = __atomic_load_n(&e->task->tid, __ATOMIC_ACQUIRE);
+		reports[count].idle_ms = (now - e->changed_ns) / 1000000U;
+		reports[count].stalled = stalled;
+
+		count++;
+	}
+
+	os_assert(0 == os_mutex_unlock(&(p->mutex)));
+
+	return count;
+}
+
+static void *
+os_watchdog_main(void *param)
+{
+	os_watchdog_t *p = param;
+	os_watchdog_report_t reports[OS_WATCHDOG_TASKS_MAX];
+
+	while (!os_task_wait_stop(&(p->monitor), p->interval_ms))
+	{
+		uint32_t count = os_watchdog_check(p, reports);
+
+		/* Report outside the mutex; logging and posting may block */
+		for (uint32_t i = 0U; i < count; i++)
+		{
+			os_watchdog_report_t *r = &reports[i];
+
+			if (NULL != p->log && r->stalled)
+				os_log_wrn(p->log, "Task '%s' (tid %d) stalled: no heartbeat for %llu ms",
+						   r->name, (int) r->tid, (unsigned long long) r->idle_ms);
+			else if (NULL != p->log)
+				os_log_wrn(p->log, "Task '%s' (tid %d) recovered", r->name, (int) r->tid);
+
+			if (NULL != p->queue && -1 == os_queue_post3(p->queue, p->msg_id, (uint32_t) r->tid,
+														 (uint32_t) r->idle_ms, r->stalled ? 1U : 0U))
+			{
+				OS_PRV_WRN("os_watchdog_main(): os_queue_post3() failed: %d", os_errno);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+int
+os_watchdog_init(os_watchdog_t *p, long interval_ms, os_log_t *log, os_queue_t *queue, uint32_t msg_id)
+{
+	if (NULL == p || interval_ms < 1L || (NULL != queue && msg_id > (OS_QUEUE_MSGID_MAX - 1U)))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out new watchdog memory */
+	memset(p, 0, sizeof(*p));
+
+	p->interval_ms = interval_ms;
+	p->log		   = log;
+	p->queue	   = queue;
+	p->msg_id	   = msg_id;
+
+	/* Obtain the watchdog's control block mutex */
+	if (-1 == os_mutex_init(&(p->mutex)))
+	{
+		/* Set os_errno to indicate unable to obtain/release resource mutex */
+		os_errno = OS_EMUTEX;
+
+		return -1;
+	}
+
+	if (-1 == os_task_init(&(p->monitor), "watchdog", os_watchdog_main, p))
+	{
+		os_mutex_destroy(&(p->mutex));
+
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+os_watchdog_destroy(os_watchdog_t *p)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Stop and join the monitor task */
+	if (-1 == os_task_destroy(&(p->monitor)))
+		return -1;
+
+	/* Destroy watchdog's mutex */
+	os_mutex_destroy(&(p->mutex));
+
+	/* Clear memory */
+	memset(p, 0, sizeof(*p));
+
+	return 0;
+}
+
+int
+os_watchdog_add(os_watchdog_t *p, os_task_t *task, long budget_ms)
+{
+	os_watchdog_entry_t *e;
+
+	if (NULL == p || NULL == task || budget_ms < 1L)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Obtain the watchdog's control block mutex */
+	if (-1 == os_mutex_lock(&(p->mutex)))
+	{
+		/* Set os_errno to indicate unable to obtain/release resource mutex */
+		os_errno = OS_EMUTEX;
+
+		return -1;
+	}
+
+	if (OS_WATCHDOG_TASKS_MAX == p->count)
+	{
+		os_mutex_unlock(&(p->mutex));
+
+		/* Set os_errno to indicate the task table is full */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	e = &p->entries[p->count++];
+
+	e->task		  = task;
+	e->budget_ns  = (uint64_t) budget_ms * 1000000U;
+	e->heartbeat  = __atomic_load_n(&task->heartbeat, __ATOMIC_RELAXED);
+	e->changed_ns = os_prv_now_ns();
+	e->stalled	  = false;
+
+	os_mutex_unlock(&(p->mutex));
+
+	return 0;
+}
+
+int
+os_watchdog_remove(os_watchdog_t *p, os_task_t *task)
+{
+	if (NULL == p || NULL == task)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Obtain the watchdog's control block mutex */
+	if (-1 == os_mutex_lock(&(p->mutex)))
+	{
+		/* Set os_errno to indicate unable to obtain/release resource mutex */
+		os_errno = OS_EMUTEX;
+
+		return -1;
+	}
+
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		if (task == p->entries[i].task)
+		{
+			/* Move the last entry into the free slot */
+			p->entries[i] = p->entries[--p->count];
+
+			os_mutex_unlock(&(p->mutex));
+
+			return 0;
+		}
+	}
+
+	os_mutex_unlock(&(p->mutex));
+
+	/* Set os_errno to indicate the task is not monitored */
+	os_errno = OS_ENOENT;
+
+	return -1;
+}
+
+bool
+os_watchdog_stalled(os_watchdog_t *p, os_task_t *task)
+{
+	bool stalled = false;
+
+	if (NULL == p || NULL == task || -1 == os_mutex_lock(&(p->mutex)))
+		return false;
+
+	for (uint32_t i = 0U; i < p->count; i++)
+	{
+		if (task == p->entries[i].task)
+			stalled = p->entries[i].stalled;
+	}
+
+	os_mutex_unlock(&(p->mutex));
+
+	return stalled;
+}
+
+uint64_t
+os_watchdog_stalls(os_watchdog_t *p)
+{
+	uint64_t stalls;
+
+	if (NULL == p || -1 == os_mutex_lock(&(p->mutex)))
+		return 0U;
+
+	stalls = p->stalls;
+
+	os_mutex_unlock(&(p->mutex));
+
+	return stalls;
+}
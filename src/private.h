@@ -2,7 +2,12 @@
 #define OS_PRIVATE_H
 #include "config.h"
 
+#include "../inc/time.h"
+
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 /* [ERR][src/serial.c:21]: Error message */
 #if __OS_ENABLE_LOGGING
@@ -20,4 +25,59 @@
 
 #define OS_PRV_ABORT(fmt, ...) do { OS_PRV_LOG("ABORT", fmt, ##__VA_ARGS__); exit(1); } while (0)
 
+/* CLOCK_MONOTONIC time in nanoseconds (timestamps, deadlines and statistics) */
+static inline uint64_t
+os_prv_now_ns()
+{
+	os_time_t now = os_time_monotonic();
+
+	return ((uint64_t) now.tv_sec * 1000000000U) + (uint64_t) now.tv_nsec;
+}
+
+/* Task running on the calling thread, NULL if not started by os_task_create() (port/<os>/task.c) */
+struct os_task_s *os_prv_task_self();
+
+/*
+ * Sleep while *p_word == value until woken, the absolute CLOCK_MONOTONIC deadline passes
+ * (NULL = none) or, on a task thread, os_task_stop() is called for the task (port/<os>/task.c).
+ * Returns -1 when the deadline passed, 0 otherwise; callers re-check their own condition.
+*/
+int os_prv_task_futex_wait(uint32_t *p_word, uint32_t value, const os_time_t *deadline);
+
+/* Wake the thread blocked on an os_rbuf_spsc_t cursor (defined in port/<os>/rbuf_wait.c) */
+void os_rbuf_spsc_wake(uint32_t *p_cursor);
+
+/* Ring buffer helpers shared by os_rbuf_t and its variants ('pos' is an index into the pool) */
+
+/* Length of the part of [pos, pos + len) that fits before the end of the pool */
+static inline size_t
+os_prv_ring_first(size_t pool_size, size_t pos, size_t len)
+{
+	return (len <= pool_size - pos) ? len : pool_size - pos;
+}
+
+static inline void
+os_prv_ring_copy_in(uint8_t *pool, size_t pool_size, size_t pos, const uint8_t *bytes, size_t nbytes)
+{
+	size_t first = os_prv_ring_first(pool_size, pos, nbytes);
+
+	/* Copy at most two contiguous segments (split at the end of the pool) */
+	memcpy(&pool[pos], bytes, first);
+
+	if (nbytes > first)
+		memcpy(pool, bytes + first, nbytes - first);
+}
+
+static inline void
+os_prv_ring_copy_out(const uint8_t *pool, size_t pool_size, size_t pos, uint8_t *p_buffer, size_t count)
+{
+	size_t first = os_prv_ring_first(pool_size, pos, count);
+
+	/* Copy at most two contiguous segments (split at the end of the pool) */
+	memcpy(p_buffer, &pool[pos], first);
+
+	if (count > first)
+		memcpy(p_buffer + first, pool, count - first);
+}
+
 #endif
@@ -4,6 +4,7 @@
 
 #include "private.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
@@ -33,14 +34,45 @@ os_rbuf_init(os_rbuf_t *p, uint8_t *p_pool, uint32_t pool_size)
 	}
 
 	/* Initialize byte storage pool */
-	p->pool = p_pool;
-	p->size = pool_size - 1U;
-	p->head = 0U;
-	p->tail = 0U;
+	p->pool  = p_pool;
+	p->size  = pool_size - 1U;
+	p->head  = 0U;
+	p->tail  = 0U;
+	p->flags = 0U;
+
+	p->dropped = 0U;
+
+	return 0;
+}
+
+int
+os_rbuf_set_overwrite(os_rbuf_t *p, bool enable)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	if (enable)
+		p->flags |= OS_RBUF_F_OVERWRITE;
+	else
+		p->flags &= ~OS_RBUF_F_OVERWRITE;
 
 	return 0;
 }
 
+uint64_t
+os_rbuf_dropped(os_rbuf_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	return p->dropped;
+}
+
 int
 os_rbuf_change_size(os_rbuf_t *p, uint32_t pool_size)
 {
@@ -52,6 +84,15 @@ os_rbuf_change_size(os_rbuf_t *p, uint32_t pool_size)
 		return -1;
 	}
 
+	/* The mirror mapping is sized at creation */
+	if (0U != (p->flags & OS_RBUF_F_MIRROR))
+	{
+		/* Set os_errno to indicate operation not supported */
+		os_errno = OS_ENOSUP;
+
+		return -1;
+	}
+
 	/* Byte pool size must be power of 2 for cursor calculation logic */
 	if (0U != (pool_size & (pool_size - 1U)))
 	{
@@ -82,9 +123,10 @@ os_rbuf_flush(os_rbuf_t *p)
 		return -1;
 	}
 
-	/* Reset byte pool cursor values */
-	p->head = 0U;
-	p->tail = 0U;
+	/* Reset byte pool cursor values and the overwrite statistics */
+	p->head	   = 0U;
+	p->tail	   = 0U;
+	p->dropped = 0U;
 
 	return 0;
 }
@@ -107,9 +149,57 @@ os_rbuf_free(os_rbuf_t *p)
 	return ((p->head - p->tail) - 1U) & p->size;
 }
 
+/*
+ * Make room for *p_nbytes bytes (whole values of 'width' bytes). In overwrite mode the
+ * oldest bytes are discarded in multiples of 'width' and, if the data is larger than the
+ * pool, *p_nbytes is reduced to the newest values that fit.
+*/
+static int
+os_rbuf_make_room(os_rbuf_t *p, uint32_t *p_nbytes, uint32_t width)
+{
+	uint32_t drop;
+
+	/* Prevent byte pool overflow */
+	if (os_rbuf_free(p) >= *p_nbytes)
+		return 0;
+
+	if (0U == (p->flags & OS_RBUF_F_OVERWRITE))
+	{
+		/* Indicate buffer will overflow */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	/* Only the newest values fit in the byte pool */
+	if (*p_nbytes > p->size)
+	{
+		drop = *p_nbytes - ((p->size / width) * width);
+
+		p->dropped += drop;
+		*p_nbytes  -= drop;
+
+		/* Values wider than the whole pool leave nothing to store */
+		if (os_rbuf_free(p) >= *p_nbytes)
+			return 0;
+	}
+
+	/* Discard the oldest bytes to make room, whole values so typed data stays aligned */
+	drop = ((*p_nbytes - os_rbuf_free(p)) + width - 1U) / width * width;
+	if (drop > os_rbuf_used(p))
+		drop = os_rbuf_used(p);
+
+	p->dropped += drop;
+	p->head		= (p->head + drop) & p->size;
+
+	return 0;
+}
+
 int
 os_rbuf_push(os_rbuf_t *p, const uint8_t *bytes, uint32_t nbytes)
 {
+	uint32_t len = nbytes;
+
 	if (NULL == p || NULL == bytes || 0U == nbytes)
 	{
 		/* Set os_errno to indicate invalid arguments */
@@ -118,25 +208,43 @@ os_rbuf_push(os_rbuf_t *p, const uint8_t *bytes, uint32_t nbytes)
 		return -1;
 	}
 
-	/* Prevent byte pool overflow */
-	if (os_rbuf_free(p) < nbytes)
+	if (-1 == os_rbuf_make_room(p, &len, 1U))
+		return -1;
+
+	/* Add the newest bytes to the byte pool */
+	os_prv_ring_copy_in(p->pool, p->size + 1U, p->tail, bytes + (nbytes - len), len);
+
+	/* Update the pool tail curser after inserting */
+	p->tail = (p->tail + len) & p->size;
+
+	return 0;
+}
+
+/* Push one encoded value; overwrite mode discards the oldest data in whole values of its width */
+static int
+os_rbuf_push_value(os_rbuf_t *p, const uint8_t *bytes, uint32_t width)
+{
+	uint32_t len = width;
+
+	if (NULL == p)
 	{
-		/* Indicate buffer will overflow */
-		os_errno = OS_EOVERFLOW;
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
 
 		return -1;
 	}
 
-	/* Add bytes to the byte pool */
-	for (uint32_t i = 0U; i < nbytes; i++)
-	{
-		uint32_t ix = (p->tail + i) & p->size;
+	if (-1 == os_rbuf_make_room(p, &len, width))
+		return -1;
 
-		p->pool[ix] = bytes[i];
-	}
+	/* Value wider than the whole pool was dropped */
+	if (0U == len)
+		return 0;
+
+	os_prv_ring_copy_in(p->pool, p->size + 1U, p->tail, bytes, len);
 
 	/* Update the pool tail curser after inserting */
-	p->tail = (p->tail + nbytes) & p->size;
+	p->tail = (p->tail + len) & p->size;
 
 	return 0;
 }
@@ -157,7 +265,7 @@ os_rbuf_push_u16(os_rbuf_t *p, uint16_t value)
 		(uint8_t)(value)
 	};
 
-	return os_rbuf_push(p, tmp, sizeof(tmp));
+	return os_rbuf_push_value(p, tmp, sizeof(tmp));
 }
 
 int
@@ -170,7 +278,7 @@ os_rbuf_push_u32(os_rbuf_t *p, uint32_t value)
 		(uint8_t)(value)
 	};
 
-	return os_rbuf_push(p, tmp, sizeof(tmp));
+	return os_rbuf_push_value(p, tmp, sizeof(tmp));
 }
 
 #ifdef __LP64__
@@ -189,7 +297,7 @@ os_rbuf_push_u64(os_rbuf_t *p, uint64_t value)
 		(uint8_t)(value)
 	};
 
-	return os_rbuf_push(p, tmp, sizeof(tmp));
+	return os_rbuf_push_value(p, tmp, sizeof(tmp));
 }
 
 #endif
@@ -206,7 +314,7 @@ os_rbuf_peek(os_rbuf_t *p, uint32_t offset, uint8_t *p_buffer, uint32_t count)
 	}
 
 	/* Ensure the byte pool has enough data to read (from the desired offset) */
-	if (os_rbuf_used(p) + offset < count)
+	if (os_rbuf_used(p) < (uint64_t) offset + count)
 	{
 		/* Set os_errno to indicate not enough data in pool */
 		os_errno = OS_ENOENT;
@@ -215,8 +323,7 @@ os_rbuf_peek(os_rbuf_t *p, uint32_t offset, uint8_t *p_buffer, uint32_t count)
 	}
 
 	/* Copy bytes to caller's buffer */
-	for (uint32_t i = 0U; i < count; i++)
-		p_buffer[i] = p->pool[(p->head + i + offset) & p->size];
+	os_prv_ring_copy_out(p->pool, p->size + 1U, (p->head + offset) & p->size, p_buffer, count);
 
 	return 0;
 }
@@ -305,7 +412,7 @@ os_rbuf_peek_u64(os_rbuf_t *p, uint32_t offset, uint64_t *p_value)
 int
 os_rbuf_pop(os_rbuf_t *p, uint8_t *p_buffer, uint32_t count)
 {
-	if (NULL == p || NULL == p_buffer || 0U == count)
+	if (NULL == p || 0U == count)
 	{
 		/* Set os_errno to indicate invalid arguments */
 		os_errno = OS_EINVAL;
@@ -322,9 +429,9 @@ os_rbuf_pop(os_rbuf_t *p, uint8_t *p_buffer, uint32_t count)
 		return -1;
 	}
 
-	/* Copy bytes to caller's buffer */
-	for (uint32_t i = 0U; i < count; i++)
-		p_buffer[i] = p->pool[(p->head + i) & p->size];
+	/* Copy bytes to caller's buffer (if provided) */
+	if (NULL != p_buffer)
+		os_prv_ring_copy_out(p->pool, p->size + 1U, p->head, p_buffer, count);
 
 	/* Update the byte pool head cursor */
 	p->head = (p->head + count) & p->size;
@@ -335,6 +442,15 @@ os_rbuf_pop(os_rbuf_t *p, uint8_t *p_buffer, uint32_t count)
 int
 os_rbuf_pop_u8(os_rbuf_t *p, uint8_t *p_value)
 {
+	/* Unlike os_rbuf_pop(), typed pops need a destination; use os_rbuf_consume() to discard */
+	if (NULL == p_value)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
 	return os_rbuf_pop(p, p_value, 1U);
 }
 
@@ -404,3 +520,427 @@ os_rbuf_pop_u64(os_rbuf_t *p, uint64_t *p_value)
 }
 
 #endif
+
+static int
+os_rbuf_spans(os_rbuf_t *p, uint32_t pos, uint32_t len, os_rbuf_span_t spans[2])
+{
+	uint32_t first = (uint32_t) os_prv_ring_first(p->size + 1U, pos, len);
+
+	spans[0] = (os_rbuf_span_t){ NULL, 0U };
+	spans[1] = (os_rbuf_span_t){ NULL, 0U };
+
+	if (0U == len)
+		return 0;
+
+	/* Region fits before the end of the pool (or runs into the mirror mapping) */
+	if (len == first || 0U != (p->flags & OS_RBUF_F_MIRROR))
+	{
+		spans[0] = (os_rbuf_span_t){ &p->pool[pos], len };
+
+		return 1;
+	}
+
+	/* Region wraps; second part starts at the beginning of the pool */
+	spans[0] = (os_rbuf_span_t){ &p->pool[pos], first };
+	spans[1] = (os_rbuf_span_t){ p->pool, len - first };
+
+	return 2;
+}
+
+int
+os_rbuf_read_spans(os_rbuf_t *p, os_rbuf_span_t spans[2])
+{
+	if (NULL == p || NULL == spans)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	return os_rbuf_spans(p, p->head, os_rbuf_used(p), spans);
+}
+
+int
+os_rbuf_write_spans(os_rbuf_t *p, os_rbuf_span_t spans[2])
+{
+	if (NULL == p || NULL == spans)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	return os_rbuf_spans(p, p->tail, os_rbuf_free(p), spans);
+}
+
+int
+os_rbuf_consume(os_rbuf_t *p, uint32_t count)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Ensure the byte pool has enough data to release */
+	if (os_rbuf_used(p) < count)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Update the byte pool head cursor */
+	p->head = (p->head + count) & p->size;
+
+	return 0;
+}
+
+int
+os_rbuf_produce(os_rbuf_t *p, uint32_t count)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Prevent byte pool overflow */
+	if (os_rbuf_free(p) < count)
+	{
+		/* Indicate buffer will overflow */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	/* Update the pool tail curser after writing */
+	p->tail = (p->tail + count) & p->size;
+
+	return 0;
+}
+
+static bool
+os_rbuf_match(const os_rbuf_span_t spans[2], uint32_t pos, const uint8_t *pattern, uint32_t pattern_len)
+{
+	uint32_t first;
+
+	/* Match lies entirely in the second span */
+	if (pos >= spans[0].len)
+		return (0 == memcmp(&spans[1].data[pos - spans[0].len], pattern, pattern_len));
+
+	/* Match lies entirely in the first span */
+	first = spans[0].len - pos;
+	if (pattern_len <= first)
+		return (0 == memcmp(&spans[0].data[pos], pattern, pattern_len));
+
+	/* Match straddles the wrap boundary */
+	return (0 == memcmp(&spans[0].data[pos], pattern, first)) &&
+		   (0 == memcmp(spans[1].data, pattern + first, pattern_len - first));
+}
+
+int
+os_rbuf_find(os_rbuf_t *p, uint32_t offset, const uint8_t *pattern, uint32_t pattern_len, uint32_t *p_pos)
+{
+	os_rbuf_span_t spans[2];
+	uint32_t used;
+	uint32_t pos = offset;
+
+	if (NULL == p || NULL == pattern || 0U == pattern_len || NULL == p_pos)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	os_rbuf_read_spans(p, spans);
+
+	used = spans[0].len + spans[1].len;
+
+	/* Scan for the first pattern byte with memchr, then verify the rest */
+	while ((uint64_t) pos + pattern_len <= used)
+	{
+		const os_rbuf_span_t *span = (pos < spans[0].len) ? &spans[0] : &spans[1];
+		uint32_t base  = (pos < spans[0].len) ? 0U : spans[0].len;
+		uint32_t limit = span->len - (pos - base);
+		const uint8_t *hit;
+
+		/* Don't scan past the last possible match position */
+		if ((uint64_t) base + span->len > (uint64_t) used - pattern_len + 1U)
+			limit = (used - pattern_len + 1U) - pos;
+
+		hit = memchr(&span->data[pos - base], pattern[0], limit);
+		if (NULL == hit)
+		{
+			/* Continue in the next span (if any) */
+			pos += limit;
+
+			continue;
+		}
+
+		pos = base + (uint32_t)(hit - span->data);
+
+		if (1U == pattern_len || os_rbuf_match(spans, pos, pattern, pattern_len))
+		{
+			*p_pos = pos;
+
+			return 0;
+		}
+
+		pos++;
+	}
+
+	/* Set os_errno to indicate the pattern was not found */
+	os_errno = OS_ENOENT;
+
+	return -1;
+}
+
+int
+os_rbuf_find_u8(os_rbuf_t *p, uint32_t offset, uint8_t value, uint32_t *p_pos)
+{
+	return os_rbuf_find(p, offset, &value, 1U, p_pos);
+}
+
+static void
+os_rbuf_convert(uint8_t *dst, const uint8_t *src, uint32_t count, uint32_t width, bool swap)
+{
+	/* Fixed-width loops; the compiler turns these into (vectorized) byte swaps */
+	if (!swap)
+	{
+		memcpy(dst, src, (size_t) count * width);
+	}
+	else if (2U == width)
+	{
+		for (uint32_t i = 0U; i < count; i++)
+		{
+			uint16_t v;
+
+			memcpy(&v, &src[i * 2U], sizeof(v));
+			v = __builtin_bswap16(v);
+			memcpy(&dst[i * 2U], &v, sizeof(v));
+		}
+	}
+	else if (4U == width)
+	{
+		for (uint32_t i = 0U; i < count; i++)
+		{
+			uint32_t v;
+
+			memcpy(&v, &src[i * 4U], sizeof(v));
+			v = __builtin_bswap32(v);
+			memcpy(&dst[i * 4U], &v, sizeof(v));
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0U; i < count; i++)
+		{
+			uint64_t v;
+
+			memcpy(&v, &src[i * 8U], sizeof(v));
+			v = __builtin_bswap64(v);
+			memcpy(&dst[i * 8U], &v, sizeof(v));
+		}
+	}
+}
+
+static void
+os_rbuf_encode(const os_rbuf_span_t spans[2], const uint8_t *values, uint32_t count, uint32_t width, bool swap)
+{
+	uint32_t whole = spans[0].len / width;
+	uint32_t split = spans[0].len % width;
+	uint32_t skip  = 0U;
+
+	/* Values that fit in the first span */
+	os_rbuf_convert(spans[0].data, values, whole, width, swap);
+
+	/* Value straddling the end of the pool */
+	if (0U != split)
+	{
+		uint8_t tmp[8U];
+
+		os_rbuf_convert(tmp, &values[whole * width], 1U, width, swap);
+
+		memcpy(&spans[0].data[whole * width], tmp, split);
+		memcpy(spans[1].data, &tmp[split], width - split);
+
+		skip = width - split;
+		whole++;
+	}
+
+	/* Remaining values at the start of the pool */
+	if (whole < count)
+		os_rbuf_convert(&spans[1].data[skip], &values[whole * width], count - whole, width, swap);
+}
+
+static void
+os_rbuf_decode(const os_rbuf_span_t spans[2], uint8_t *values, uint32_t count, uint32_t width, bool swap)
+{
+	uint32_t whole = spans[0].len / width;
+	uint32_t split = spans[0].len % width;
+	uint32_t skip  = 0U;
+
+	/* Values that fit in the first span */
+	os_rbuf_convert(values, spans[0].data, whole, width, swap);
+
+	/* Value straddling the end of the pool */
+	if (0U != split)
+	{
+		uint8_t tmp[8U];
+
+		memcpy(tmp, &spans[0].data[whole * width], split);
+		memcpy(&tmp[split], spans[1].data, width - split);
+
+		os_rbuf_convert(&values[whole * width], tmp, 1U, width, swap);
+
+		skip = width - split;
+		whole++;
+	}
+
+	/* Remaining values at the start of the pool */
+	if (whole < count)
+		os_rbuf_convert(&values[whole * width], &spans[1].data[skip], count - whole, width, swap);
+}
+
+static int
+os_rbuf_push_v(os_rbuf_t *p, const void *values, uint32_t count, uint32_t width, bool big_endian)
+{
+	os_rbuf_span_t spans[2];
+	uint32_t nbytes;
+	uint32_t len;
+
+	if (NULL == p || NULL == values || 0U == count || count > UINT32_MAX / width)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	nbytes = count * width;
+	len	   = nbytes;
+
+	if (-1 == os_rbuf_make_room(p, &len, width))
+		return -1;
+
+	/* Values wider than the whole pool were all dropped */
+	if (0U == len)
+		return 0;
+
+	/* Convert the newest values straight into the byte pool */
+	os_rbuf_spans(p, p->tail, len, spans);
+	os_rbuf_encode(spans, (const uint8_t *) values + (nbytes - len), len / width, width,
+				   big_endian != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__));
+
+	/* Update the pool tail curser after inserting */
+	p->tail = (p->tail + len) & p->size;
+
+	return 0;
+}
+
+static int
+os_rbuf_peek_v(os_rbuf_t *p, uint32_t offset, void *values, uint32_t count, uint32_t width, bool big_endian)
+{
+	os_rbuf_span_t spans[2];
+	uint32_t nbytes;
+
+	if (NULL == p || NULL == values || 0U == count || count > UINT32_MAX / width)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	nbytes = count * width;
+
+	/* Ensure the byte pool has enough data to read (from the desired offset) */
+	if (os_rbuf_used(p) < (uint64_t) offset + nbytes)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Convert the values straight out of the byte pool */
+	os_rbuf_spans(p, (p->head + offset) & p->size, nbytes, spans);
+	os_rbuf_decode(spans, values, count, width, big_endian != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__));
+
+	return 0;
+}
+
+static int
+os_rbuf_pop_v(os_rbuf_t *p, void *values, uint32_t count, uint32_t width, bool big_endian)
+{
+	if (-1 == os_rbuf_peek_v(p, 0U, values, count, width, big_endian))
+		return -1;
+
+	/* Update the byte pool head cursor */
+	p->head = (p->head + (count * width)) & p->size;
+
+	return 0;
+}
+
+int
+os_rbuf_push_u16v(os_rbuf_t *p, const uint16_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_push_v(p, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_push_u32v(os_rbuf_t *p, const uint32_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_push_v(p, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_push_u64v(os_rbuf_t *p, const uint64_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_push_v(p, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_peek_u16v(os_rbuf_t *p, uint32_t offset, uint16_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_peek_v(p, offset, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_peek_u32v(os_rbuf_t *p, uint32_t offset, uint32_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_peek_v(p, offset, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_peek_u64v(os_rbuf_t *p, uint32_t offset, uint64_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_peek_v(p, offset, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_pop_u16v(os_rbuf_t *p, uint16_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_pop_v(p, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_pop_u32v(os_rbuf_t *p, uint32_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_pop_v(p, values, count, sizeof(*values), big_endian);
+}
+
+int
+os_rbuf_pop_u64v(os_rbuf_t *p, uint64_t *values, uint32_t count, bool big_endian)
+{
+	return os_rbuf_pop_v(p, values, count, sizeof(*values), big_endian);
+}
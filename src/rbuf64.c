@@ -0,0 +1,271 @@
+#include "../inc/rbuf64.h"
+#include "../inc/errno.h"
+
+#include "private.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ------------------------------------------------------------ */
+
+static int
+os_rbuf64_spans(os_rbuf64_t *p, uint64_t cursor, uint64_t len, os_rbuf64_span_t spans[2])
+{
+	uint64_t pos   = cursor & p->mask;
+	uint64_t first = os_prv_ring_first(p->size, pos, len);
+
+	spans[0] = (os_rbuf64_span_t){ NULL, 0U };
+	spans[1] = (os_rbuf64_span_t){ NULL, 0U };
+
+	if (0U == len)
+		return 0;
+
+	/* Region fits before the end of the pool */
+	if (len == first)
+	{
+		spans[0] = (os_rbuf64_span_t){ &p->pool[pos], len };
+
+		return 1;
+	}
+
+	/* Region wraps; second part starts at the beginning of the pool */
+	spans[0] = (os_rbuf64_span_t){ &p->pool[pos], first };
+	spans[1] = (os_rbuf64_span_t){ p->pool, len - first };
+
+	return 2;
+}
+
+int
+os_rbuf64_init(os_rbuf64_t *p, uint8_t *p_pool, uint64_t pool_size)
+{
+	if (NULL == p || NULL == p_pool || 0U == pool_size)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Byte pool size must be power of 2 for cursor calculation logic */
+	if (0U != (pool_size & (pool_size - 1U)))
+	{
+		OS_PRV_ERR("os_rbuf64_init(): (0U != (pool_size & (pool_size - 1U)))");
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Initialize byte storage pool */
+	p->pool = p_pool;
+	p->size = pool_size;
+	p->mask = pool_size - 1U;
+	p->head = 0U;
+	p->tail = 0U;
+
+	return 0;
+}
+
+int
+os_rbuf64_flush(os_rbuf64_t *p)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Reset byte pool cursor values */
+	p->head = 0U;
+	p->tail = 0U;
+
+	return 0;
+}
+
+uint64_t
+os_rbuf64_used(os_rbuf64_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	/* Cursors are free-running; the difference never exceeds the pool size */
+	return p->tail - p->head;
+}
+
+uint64_t
+os_rbuf64_free(os_rbuf64_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	return p->size - (p->tail - p->head);
+}
+
+int
+os_rbuf64_push(os_rbuf64_t *p, const uint8_t *bytes, uint64_t nbytes)
+{
+	if (NULL == p || NULL == bytes || 0U == nbytes)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Prevent byte pool overflow */
+	if (os_rbuf64_free(p) < nbytes)
+	{
+		/* Indicate buffer will overflow */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	/* Add bytes to the byte pool */
+	os_prv_ring_copy_in(p->pool, p->size, p->tail & p->mask, bytes, nbytes);
+
+	/* Update the pool tail cursor after inserting */
+	p->tail += nbytes;
+
+	return 0;
+}
+
+int
+os_rbuf64_peek(os_rbuf64_t *p, uint64_t offset, uint8_t *p_buffer, uint64_t count)
+{
+	if (NULL == p || NULL == p_buffer || 0U == count)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Ensure the byte pool has enough data to read (from the desired offset) */
+	if (os_rbuf64_used(p) < count || os_rbuf64_used(p) - count < offset)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Copy bytes to caller's buffer */
+	os_prv_ring_copy_out(p->pool, p->size, (p->head + offset) & p->mask, p_buffer, count);
+
+	return 0;
+}
+
+int
+os_rbuf64_pop(os_rbuf64_t *p, uint8_t *p_buffer, uint64_t count)
+{
+	if (NULL == p || 0U == count)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Ensure the byte pool has enough data to read */
+	if (os_rbuf64_used(p) < count)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Copy bytes to caller's buffer (if provided) */
+	if (NULL != p_buffer)
+		os_prv_ring_copy_out(p->pool, p->size, p->head & p->mask, p_buffer, count);
+
+	/* Update the byte pool head cursor */
+	p->head += count;
+
+	return 0;
+}
+
+int
+os_rbuf64_read_spans(os_rbuf64_t *p, os_rbuf64_span_t spans[2])
+{
+	if (NULL == p || NULL == spans)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	return os_rbuf64_spans(p, p->head, os_rbuf64_used(p), spans);
+}
+
+int
+os_rbuf64_write_spans(os_rbuf64_t *p, os_rbuf64_span_t spans[2])
+{
+	if (NULL == p || NULL == spans)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	return os_rbuf64_spans(p, p->tail, os_rbuf64_free(p), spans);
+}
+
+int
+os_rbuf64_consume(os_rbuf64_t *p, uint64_t count)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Ensure the byte pool has enough data to release */
+	if (os_rbuf64_used(p) < count)
+	{
+		/* Set os_errno to indicate not enough data in pool */
+		os_errno = OS_ENOENT;
+
+		return -1;
+	}
+
+	/* Update the byte pool head cursor */
+	p->head += count;
+
+	return 0;
+}
+
+int
+os_rbuf64_produce(os_rbuf64_t *p, uint64_t count)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Prevent byte pool overflow */
+	if (os_rbuf64_free(p) < count)
+	{
+		/* Indicate buffer will overflow */
+		os_errno = OS_EOVERFLOW;
+
+		return -1;
+	}
+
+	/* Update the pool tail cursor after writing */
+	p->tail += count;
+
+	return 0;
+}
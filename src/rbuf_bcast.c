@@ -0,0 +1,319 @@
+#include "../inc/rbuf_bcast.h"
+#include "../inc/errno.h"
+
+#include "private.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ------------------------------------------------------------ */
+
+static inline bool
+os_rbuf_bcast_valid(os_rbuf_bcast_t *p, uint32_t reader)
+{
+	return NULL != p && reader < OS_RBUF_BCAST_READERS_MAX && 0U != __atomic_load_n(&p->readers[reader].active, __ATOMIC_ACQUIRE);
+}
+
+static uint64_t
+os_rbuf_bcast_slowest(os_rbuf_bcast_t *p, uint64_t tail)
+{
+	uint64_t head = tail;
+
+	/* Find the attached reader furthest behind (no reader = nothing to wait for) */
+	for (uint32_t i = 0U; i < OS_RBUF_BCAST_READERS_MAX; i++)
+	{
+		os_rbuf_bcast_reader_t *r = &p->readers[i];
+		uint64_t h;
+
+		if (0U == __atomic_load_n(&r->active, __ATOMIC_ACQUIRE))
+			continue;
+
+		/* Acquire pairs with the reader's release; its reads of the pool are complete */
+		h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+		if (tail - h > tail - head)
+			head = h;
+	}
+
+	return head;
+}
+
+static void
+os_rbuf_bcast_overrun(os_rbuf_bcast_t *p, uint64_t need)
+{
+	/* Move every reader behind 'need' forward before its bytes are overwritten */
+	for (uint32_t i = 0U; i < OS_RBUF_BCAST_READERS_MAX; i++)
+	{
+		os_rbuf_bcast_reader_t *r = &p->readers[i];
+		uint64_t h;
+
+		if (0U == __atomic_load_n(&r->active, __ATOMIC_ACQUIRE))
+			continue;
+
+		h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+		/* Racing with the reader's own update; retry with its latest cursor */
+		while ((int64_t)(need - h) > 0)
+		{
+			if (__atomic_compare_exchange_n(&r->head, &h, need, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			{
+				__atomic_fetch_add(&r->lost, need - h, __ATOMIC_RELAXED);
+
+				break;
+			}
+		}
+	}
+}
+
+int
+os_rbuf_bcast_init(os_rbuf_bcast_t *p, uint8_t *p_pool, uint64_t pool_size, bool lossy)
+{
+	if (NULL == p || NULL == p_pool || 0U == pool_size)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Byte pool size must be power of 2 for cursor calculation logic */
+	if (0U != (pool_size & (pool_size - 1U)))
+	{
+		OS_PRV_ERR("os_rbuf_bcast_init(): (0U != (pool_size & (pool_size - 1U)))");
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out ring buffer memory */
+	memset(p, 0, sizeof(*p));
+
+	/* Initialize byte storage pool */
+	p->pool  = p_pool;
+	p->size  = pool_size;
+	p->mask  = pool_size - 1U;
+	p->lossy = lossy;
+
+	return 0;
+}
+
+int
+os_rbuf_bcast_attach(os_rbuf_bcast_t *p, uint32_t *p_reader)
+{
+	if (NULL == p || NULL == p_reader)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	for (uint32_t i = 0U; i < OS_RBUF_BCAST_READERS_MAX; i++)
+	{
+		os_rbuf_bcast_reader_t *r = &p->readers[i];
+		uint32_t expected = 0U;
+
+		/* Claim a free reader slot */
+		if (!__atomic_compare_exchange_n(&r->claimed, &expected, 1U, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			continue;
+
+		/*
+		 * New readers start at the current end of the data. The cursor is stored before
+		 * the slot is published (release), so a writer that sees the reader as active
+		 * also sees its start position.
+		*/
+		__atomic_store_n(&r->lost, 0U, __ATOMIC_RELAXED);
+		__atomic_store_n(&r->head, __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+		__atomic_store_n(&r->active, 1U, __ATOMIC_RELEASE);
+
+		*p_reader = i;
+
+		return 0;
+	}
+
+	/* Set os_errno to indicate no free reader slot */
+	os_errno = OS_EOVERFLOW;
+
+	return -1;
+}
+
+int
+os_rbuf_bcast_detach(os_rbuf_bcast_t *p, uint32_t reader)
+{
+	if (!os_rbuf_bcast_valid(p, reader))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	__atomic_store_n(&p->readers[reader].active, 0U, __ATOMIC_RELEASE);
+	__atomic_store_n(&p->readers[reader].claimed, 0U, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+uint64_t
+os_rbuf_bcast_free(os_rbuf_bcast_t *p)
+{
+	uint64_t tail;
+
+	if (NULL == p)
+		return 0U;
+
+	if (p->lossy)
+		return p->size;
+
+	/* Only the writer writes the tail cursor */
+	tail = __atomic_load_n(&p->tail, __ATOMIC_RELAXED);
+
+	return p->size - (tail - os_rbuf_bcast_slowest(p, tail));
+}
+
+int
+os_rbuf_bcast_push(os_rbuf_bcast_t *p, const uint8_t *bytes, uint64_t nbytes)
+{
+	uint64_t tail;
+
+	if (NULL == p || NULL == bytes || 0U == nbytes)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Only the writer writes the tail cursor */
+	tail = __atomic_load_n(&p->tail, __ATOMIC_RELAXED);
+
+	if (p->lossy)
+	{
+		/* Only the newest bytes fit in the byte pool */
+		if (nbytes > p->size)
+		{
+			bytes += nbytes - p->size;
+			tail  += nbytes - p->size;
+			nbytes = p->size;
+		}
+
+		/* Readers must not be left pointing at bytes about to be overwritten */
+		os_rbuf_bcast_overrun(p, (tail + nbytes) - p->size);
+	}
+	else if (p->size - (tail - p->head_cache) < nbytes)
+	{
+		/* Check against the cached slowest reader first; only rescan the readers when needed */
+		p->head_cache = os_rbuf_bcast_slowest(p, tail);
+
+		/* Prevent byte pool overflow */
+		if (p->size - (tail - p->head_cache) < nbytes)
+		{
+			/* Indicate buffer will overflow */
+			os_errno = OS_EOVERFLOW;
+
+			return -1;
+		}
+	}
+
+	/* Add bytes to the byte pool */
+	os_prv_ring_copy_in(p->pool, p->size, tail & p->mask, bytes, nbytes);
+
+	/* Publish the new bytes to the readers */
+	__atomic_store_n(&p->tail, tail + nbytes, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+uint64_t
+os_rbuf_bcast_used(os_rbuf_bcast_t *p, uint32_t reader)
+{
+	uint64_t head;
+	uint64_t tail;
+
+	if (!os_rbuf_bcast_valid(p, reader))
+		return 0U;
+
+	head = __atomic_load_n(&p->readers[reader].head, __ATOMIC_ACQUIRE);
+	tail = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+
+	/* A lossy writer may have moved the cursor past the loaded tail */
+	return ((int64_t)(tail - head) > 0) ? tail - head : 0U;
+}
+
+static int
+os_rbuf_bcast_read(os_rbuf_bcast_t *p, uint32_t reader, uint64_t offset, uint8_t *p_buffer, uint64_t count, bool remove)
+{
+	os_rbuf_bcast_reader_t *r;
+	uint64_t head;
+	uint64_t tail;
+
+	if (!os_rbuf_bcast_valid(p, reader) || 0U == count || (NULL == p_buffer && !remove))
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	r = &p->readers[reader];
+
+	while (1)
+	{
+		head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+		/* Acquire pairs with the writer's release; its writes to the pool are visible */
+		tail = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+
+		/* Ensure the byte pool has enough data to read (from the desired offset) */
+		if ((int64_t)(tail - head) <= 0 || tail - head < count || (tail - head) - count < offset)
+		{
+			/* Set os_errno to indicate not enough data in pool */
+			os_errno = OS_ENOENT;
+
+			return -1;
+		}
+
+		/* Copy bytes to caller's buffer (if provided) */
+		if (NULL != p_buffer)
+			os_prv_ring_copy_out(p->pool, p->size, (head + offset) & p->mask, p_buffer, count);
+
+		/* Without a lossy writer nobody else moves this cursor */
+		if (!p->lossy)
+			break;
+
+		/* The copy is only valid if the writer did not overrun this reader meanwhile */
+		if (__atomic_compare_exchange_n(&r->head, &head, remove ? head + count : head, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			return 0;
+	}
+
+	/* Release the space back to the writer */
+	if (remove)
+		__atomic_store_n(&r->head, head + count, __ATOMIC_RELEASE);
+
+	return 0;
+}
+
+int
+os_rbuf_bcast_peek(os_rbuf_bcast_t *p, uint32_t reader, uint64_t offset, uint8_t *p_buffer, uint64_t count)
+{
+	return os_rbuf_bcast_read(p, reader, offset, p_buffer, count, false);
+}
+
+int
+os_rbuf_bcast_pop(os_rbuf_bcast_t *p, uint32_t reader, uint8_t *p_buffer, uint64_t count)
+{
+	return os_rbuf_bcast_read(p, reader, 0U, p_buffer, count, true);
+}
+
+uint64_t
+os_rbuf_bcast_lost(os_rbuf_bcast_t *p, uint32_t reader)
+{
+	if (NULL == p || reader >= OS_RBUF_BCAST_READERS_MAX)
+		return 0U;
+
+	return __atomic_load_n(&p->readers[reader].lost, __ATOMIC_RELAXED);
+}
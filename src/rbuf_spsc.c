@@ -0,0 +1,237 @@
+#include "../inc/rbuf_spsc.h"
+#include "../inc/errno.h"
+
+#include "private.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+/* ------------------------------------------------------------ */
+
+int
+os_rbuf_spsc_init(os_rbuf_spsc_t *p, uint8_t *p_pool, uint32_t pool_size)
+{
+	if (NULL == p || NULL == p_pool || pool_size < 2U)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Byte pool size must be power of 2 for cursor calculation logic */
+	if (0U != (pool_size & (pool_size - 1U)))
+	{
+		OS_PRV_ERR("os_rbuf_spsc_init(): (0U != (pool_size & (pool_size - 1U)))");
+
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Clear out ring buffer memory */
+	memset(p, 0, sizeof(*p));
+
+	/* Initialize byte storage pool */
+	p->pool = p_pool;
+	p->size = pool_size - 1U;
+
+	return 0;
+}
+
+int
+os_rbuf_spsc_init_waitable(os_rbuf_spsc_t *p, uint8_t *p_pool, uint32_t pool_size)
+{
+	if (-1 == os_rbuf_spsc_init(p, p_pool, pool_size))
+		return -1;
+
+	p->waitable = true;
+
+	return 0;
+}
+
+int
+os_rbuf_spsc_flush(os_rbuf_spsc_t *p)
+{
+	if (NULL == p)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Reset byte pool cursor values */
+	__atomic_store_n(&p->head, 0U, __ATOMIC_RELEASE);
+	__atomic_store_n(&p->tail, 0U, __ATOMIC_RELEASE);
+
+	p->head_cache = 0U;
+	p->tail_cache = 0U;
+
+	return 0;
+}
+
+uint32_t
+os_rbuf_spsc_used(os_rbuf_spsc_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	return (__atomic_load_n(&p->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&p->head, __ATOMIC_ACQUIRE)) & p->size;
+}
+
+uint32_t
+os_rbuf_spsc_free(os_rbuf_spsc_t *p)
+{
+	if (NULL == p)
+		return 0U;
+
+	return ((__atomic_load_n(&p->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE)) - 1U) & p->size;
+}
+
+int
+os_rbuf_spsc_push(os_rbuf_spsc_t *p, const uint8_t *bytes, uint32_t nbytes)
+{
+	uint32_t tail;
+
+	if (NULL == p || NULL == bytes || 0U == nbytes)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Only the producer writes the tail cursor */
+	tail = __atomic_load_n(&p->tail, __ATOMIC_RELAXED);
+
+	/* Check against the cached consumer cursor first; only reload it when needed */
+	if ((((p->head_cache - tail) - 1U) & p->size) < nbytes)
+	{
+		/* Acquire pairs with the consumer's release; its reads of the pool are complete */
+		p->head_cache = __atomic_load_n(&p->head, __ATOMIC_ACQUIRE);
+
+		/* Prevent byte pool overflow */
+		if ((((p->head_cache - tail) - 1U) & p->size) < nbytes)
+		{
+			/* Indicate buffer will overflow */
+			os_errno = OS_EOVERFLOW;
+
+			return -1;
+		}
+	}
+
+	/* Add bytes to the byte pool */
+	os_prv_ring_copy_in(p->pool, p->size + 1U, tail, bytes, nbytes);
+
+	if (!p->waitable)
+	{
+		/* Publish the new bytes to the consumer */
+		__atomic_store_n(&p->tail, (tail + nbytes) & p->size, __ATOMIC_RELEASE);
+
+		return 0;
+	}
+
+	/* Publish the new bytes to the consumer (ordered before the waiter check) */
+	__atomic_store_n(&p->tail, (tail + nbytes) & p->size, __ATOMIC_SEQ_CST);
+
+	/* Only pay for the wake-up system call when the consumer is blocked */
+	if (0U != __atomic_load_n(&p->used_waiters, __ATOMIC_SEQ_CST))
+		os_rbuf_spsc_wake(&p->tail);
+
+	return 0;
+}
+
+int
+os_rbuf_spsc_peek(os_rbuf_spsc_t *p, uint32_t offset, uint8_t *p_buffer, uint32_t count)
+{
+	uint32_t head;
+
+	if (NULL == p || NULL == p_buffer || 0U == count)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Only the consumer writes the head cursor */
+	head = __atomic_load_n(&p->head, __ATOMIC_RELAXED);
+
+	/* Check against the cached producer cursor first; only reload it when needed */
+	if (((p->tail_cache - head) & p->size) < (uint64_t) offset + count)
+	{
+		/* Acquire pairs with the producer's release; its writes to the pool are visible */
+		p->tail_cache = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+
+		/* Ensure the byte pool has enough data to read (from the desired offset) */
+		if (((p->tail_cache - head) & p->size) < (uint64_t) offset + count)
+		{
+			/* Set os_errno to indicate not enough data in pool */
+			os_errno = OS_ENOENT;
+
+			return -1;
+		}
+	}
+
+	/* Copy bytes to caller's buffer */
+	os_prv_ring_copy_out(p->pool, p->size + 1U, (head + offset) & p->size, p_buffer, count);
+
+	return 0;
+}
+
+int
+os_rbuf_spsc_pop(os_rbuf_spsc_t *p, uint8_t *p_buffer, uint32_t count)
+{
+	uint32_t head;
+
+	if (NULL == p || 0U == count)
+	{
+		/* Set os_errno to indicate invalid arguments */
+		os_errno = OS_EINVAL;
+
+		return -1;
+	}
+
+	/* Only the consumer writes the head cursor */
+	head = __atomic_load_n(&p->head, __ATOMIC_RELAXED);
+
+	/* Check against the cached producer cursor first; only reload it when needed */
+	if (((p->tail_cache - head) & p->size) < count)
+	{
+		/* Acquire pairs with the producer's release; its writes to the pool are visible */
+		p->tail_cache = __atomic_load_n(&p->tail, __ATOMIC_ACQUIRE);
+
+		/* Ensure the byte pool has enough data to read */
+		if (((p->tail_cache - head) & p->size) < count)
+		{
+			/* Set os_errno to indicate not enough data in pool */
+			os_errno = OS_ENOENT;
+
+			return -1;
+		}
+	}
+
+	/* Copy bytes to caller's buffer (if provided) */
+	if (NULL != p_buffer)
+		os_prv_ring_copy_out(p->pool, p->size + 1U, head, p_buffer, count);
+
+	if (!p->waitable)
+	{
+		/* Release the space back to the producer */
+		__atomic_store_n(&p->head, (head + count) & p->size, __ATOMIC_RELEASE);
+
+		return 0;
+	}
+
+	/* Release the space back to the producer (ordered before the waiter check) */
+	__atomic_store_n(&p->head, (head + count) & p->size, __ATOMIC_SEQ_CST);
+
+	/* Only pay for the wake-up system call when the producer is blocked */
+	if (0U != __atomic_load_n(&p->free_waiters, __ATOMIC_SEQ_CST))
+		os_rbuf_spsc_wake(&p->head);
+
+	return 0;
+}